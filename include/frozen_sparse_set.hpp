@@ -0,0 +1,184 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include <sparse_set.hpp>
+
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// Class declarations
+////////////////////////////////////////////////////////////////////////////////
+/**
+* @brief Immutable snapshot of a sparse_set for query-only phases.
+* Only the contained indice are kept, sorted in Eytzinger (breadth first tree)
+* order so a lookup walks down the tree with one predictable load per level
+* and prefetches the cache line holding the next 4 levels.
+* Values are packed in the same order, the footprint is
+* (sizeof(uint32_t) + sizeof(Type)) * size() whatever Size is.
+* Disabled elements of a partitioned set are kept, thawing enables them.
+* Empty types and void only keep the indice, every element shares one object.
+*/
+template<typename Type, uint32_t Size>
+class frozen_sparse_set {
+public:
+    using value_type = std::conditional_t<std::is_void_v<Type>, sparse_set_tag, Type>;
+    using size_type = decltype(Size);
+    /** @brief true if only the indice are kept, see sparse_set_storage::tag */
+    static constexpr bool tagged = std::is_empty_v<value_type> && std::is_trivially_destructible_v<value_type>;
+
+    frozen_sparse_set() noexcept = default;
+    /** @brief Snapshots the content of a_Set */
+    template<typename Policy>
+    explicit frozen_sparse_set(const sparse_set<Type, Size, Policy>& a_Set);
+
+    /** @return The maximum number of elements of the set this was frozen from */
+    [[nodiscard]] constexpr size_type max_size() const noexcept;
+    /** @return The number of elements contained in the set */
+    [[nodiscard]] size_type size() const noexcept;
+    /** @return true if the set contains no element */
+    [[nodiscard]] bool empty() const noexcept;
+
+    /** @return true if a value is attached to this index, out of bound indice are absent */
+    [[nodiscard]] bool contains(size_type a_Index) const noexcept;
+    /** @return a ref to the element contained at this index */
+    [[nodiscard]] const value_type& at(size_type a_Index) const;
+    /** @return a pointer to the element contained at this index, nullptr if absent */
+    [[nodiscard]] const value_type* find(size_type a_Index) const noexcept;
+    /** @brief Calls a_Func(index, element) for each element, in unspecified order */
+    template<typename Func>
+    void for_each(Func&& a_Func) const;
+
+    /** @brief Replaces the content of a_Set with the elements of this set */
+    template<typename Policy>
+    void thaw(sparse_set<Type, Size, Policy>& a_Set) const;
+
+private:
+    /** @brief Fills the subtree rooted at a_Node by an in-order walk, which visits nodes in sorted order */
+    template<typename Sorted>
+    size_type _build(const Sorted& a_Sorted, std::vector<const value_type*>& a_Values, size_type a_Next, size_type a_Node);
+    /** @return the position of a_Index in _keys and _values, size() if absent */
+    [[nodiscard]] size_type _search(size_type a_Index) const noexcept;
+
+    std::vector<size_type> _keys; //Eytzinger order, node k has children 2k + 1 and 2k + 2
+    std::vector<value_type> _values; //left empty when tagged
+    SPARSE_SET_NO_UNIQUE_ADDRESS value_type _tag{};
+};
+
+template<typename Type, uint32_t Size>
+template<typename Policy>
+frozen_sparse_set<Type, Size>::frozen_sparse_set(const sparse_set<Type, Size, Policy>& a_Set) {
+    std::vector<std::pair<size_type, const value_type*>> sorted;
+    std::vector<value_type> copies; //soa storage hands out proxies, rebuild the elements first
+    sorted.reserve(a_Set.size());
+    if constexpr (std::is_same_v<typename sparse_set<Type, Size, Policy>::const_reference, const value_type&>) {
+        const auto gather = [&](size_type a_Index, const value_type& a_Value) { sorted.emplace_back(a_Index, &a_Value); };
+        a_Set.for_each(gather);
+        a_Set.for_each_disabled(gather);
+    }
+    else {
+        copies.reserve(a_Set.size());
+        const auto gather = [&](size_type a_Index, auto a_Value) {
+            copies.emplace_back(a_Value);
+            sorted.emplace_back(a_Index, nullptr);
+        };
+        a_Set.for_each(gather);
+        a_Set.for_each_disabled(gather);
+        for (size_t i = 0; i < sorted.size(); ++i) sorted[i].second = &copies[i];
+    }
+    std::sort(sorted.begin(), sorted.end(), [](auto& a_Left, auto& a_Right) { return a_Left.first < a_Right.first; });
+    _keys.resize(sorted.size());
+    std::vector<const value_type*> values(sorted.size());
+    _build(sorted, values, 0, 0);
+    if constexpr (!tagged) {
+        _values.reserve(sorted.size());
+        for (auto& value : values) _values.emplace_back(*value);
+    }
+}
+
+template<typename Type, uint32_t Size>
+constexpr auto frozen_sparse_set<Type, Size>::max_size() const noexcept -> size_type {
+    return Size;
+}
+
+template<typename Type, uint32_t Size>
+auto frozen_sparse_set<Type, Size>::size() const noexcept -> size_type {
+    return size_type(_keys.size());
+}
+
+template<typename Type, uint32_t Size>
+bool frozen_sparse_set<Type, Size>::empty() const noexcept {
+    return _keys.empty();
+}
+
+template<typename Type, uint32_t Size>
+bool frozen_sparse_set<Type, Size>::contains(size_type a_Index) const noexcept {
+    return _search(a_Index) != size();
+}
+
+template<typename Type, uint32_t Size>
+auto frozen_sparse_set<Type, Size>::at(size_type a_Index) const -> const value_type& {
+    const auto pos = _search(a_Index);
+    if (pos == size()) throw std::out_of_range("frozen_sparse_set::at: no element at this index");
+    if constexpr (tagged) return _tag;
+    else return _values[pos];
+}
+
+template<typename Type, uint32_t Size>
+auto frozen_sparse_set<Type, Size>::find(size_type a_Index) const noexcept -> const value_type* {
+    const auto pos = _search(a_Index);
+    if (pos == size()) return nullptr;
+    if constexpr (tagged) return &_tag;
+    else return &_values[pos];
+}
+
+template<typename Type, uint32_t Size>
+template<typename Func>
+void frozen_sparse_set<Type, Size>::for_each(Func&& a_Func) const {
+    for (size_type pos = 0; pos < size(); ++pos) {
+        if constexpr (tagged) a_Func(_keys[pos], _tag);
+        else a_Func(_keys[pos], _values[pos]);
+    }
+}
+
+template<typename Type, uint32_t Size>
+template<typename Policy>
+void frozen_sparse_set<Type, Size>::thaw(sparse_set<Type, Size, Policy>& a_Set) const {
+    a_Set.clear();
+    for (size_type pos = 0; pos < size(); ++pos) {
+        if constexpr (tagged) a_Set.insert(_keys[pos]);
+        else a_Set.insert(_keys[pos], _values[pos]);
+    }
+}
+
+template<typename Type, uint32_t Size>
+template<typename Sorted>
+auto frozen_sparse_set<Type, Size>::_build(const Sorted& a_Sorted, std::vector<const value_type*>& a_Values, size_type a_Next, size_type a_Node) -> size_type {
+    if (a_Node >= a_Sorted.size()) return a_Next;
+    a_Next = _build(a_Sorted, a_Values, a_Next, 2 * a_Node + 1);
+    _keys[a_Node] = a_Sorted[a_Next].first;
+    a_Values[a_Node] = a_Sorted[a_Next].second;
+    return _build(a_Sorted, a_Values, a_Next + 1, 2 * a_Node + 2);
+}
+
+template<typename Type, uint32_t Size>
+auto frozen_sparse_set<Type, Size>::_search(size_type a_Index) const noexcept -> size_type {
+    const size_type count = size();
+    const size_type* keys = _keys.data();
+    size_type node = 0, candidate = count;
+    while (node < count) {
+        //the 16 descendants 4 levels down share a cache line
+        sparse_set_detail::prefetch(keys + std::min(16 * node + 15, count - 1));
+        const bool right = keys[node] < a_Index;
+        candidate = right ? candidate : node; //lowest key not less than a_Index so far
+        node = 2 * node + 1 + right;
+    }
+    return candidate != count && keys[candidate] == a_Index ? candidate : count;
+}
+
+/** @return an immutable compact snapshot of a_Set, see frozen_sparse_set */
+template<typename Type, uint32_t Size, typename Policy>
+[[nodiscard]] frozen_sparse_set<Type, Size> sparse_set_freeze(const sparse_set<Type, Size, Policy>& a_Set) {
+    return frozen_sparse_set<Type, Size>(a_Set);
+}
@@ -0,0 +1,275 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include <sparse_set.hpp>
+
+#include <new>
+
+////////////////////////////////////////////////////////////////////////////////
+// Class declarations
+////////////////////////////////////////////////////////////////////////////////
+/**
+* @brief Describes an element type only known at runtime.
+* Null hooks zero the element on construction, copy or relocate its bytes and skip destruction.
+*/
+struct sparse_set_element_info {
+    size_t size{ 0 };
+    size_t alignment{ 1 };
+    void (*construct)(void* a_Element){ nullptr }; //default constructs in a_Element
+    void (*copy)(void* a_Element, const void* a_Source){ nullptr }; //copy constructs in a_Element from a_Source
+    void (*destroy)(void* a_Element){ nullptr };
+    void (*relocate)(void* a_Element, void* a_Source){ nullptr }; //moves a_Source to the unoccupied a_Element, a_Source is left unoccupied
+
+    /** @return the description of a native Type, handy to mix native and runtime elements */
+    template<typename Type>
+    [[nodiscard]] static sparse_set_element_info of() noexcept {
+        return {
+            sizeof(Type), alignof(Type),
+            [](void* a_Element) { new(a_Element) Type(); },
+            [](void* a_Element, const void* a_Source) { new(a_Element) Type(*(const Type*)a_Source); },
+            [](void* a_Element) { std::destroy_at((Type*)a_Element); },
+            std::is_trivially_copyable_v<Type> ? nullptr : +[](void* a_Element, void* a_Source) {
+                new(a_Element) Type(std::move(*(Type*)a_Source));
+                std::destroy_at((Type*)a_Source);
+            }
+        };
+    }
+};
+
+/**
+* @brief A sparse_set whose element type is described at runtime by a
+* sparse_set_element_info, for plugin or scripted components.
+* Elements are packed in a buffer of Size elements allocated on construction,
+* aligned as required, and erasing moves the last element into the hole.
+* Erasing invalidates pointers to elements like sparse_set.
+*/
+template<uint32_t Size>
+class runtime_sparse_set {
+public:
+    using size_type = decltype(Size);
+    /** @brief Erasing always packs the elements, lets sparse_set_handle view this set */
+    static constexpr bool tombstones = false;
+
+    explicit runtime_sparse_set(const sparse_set_element_info& a_Info);
+    runtime_sparse_set(const runtime_sparse_set&) = delete;
+    runtime_sparse_set& operator=(const runtime_sparse_set&) = delete;
+    ~runtime_sparse_set();
+
+    /** @return the description of the elements */
+    [[nodiscard]] const sparse_set_element_info& info() const noexcept;
+    /** @return the distance in bytes between two consecutive elements */
+    [[nodiscard]] size_t stride() const noexcept;
+    /** @return The maximum number of elements that can be inserted in the set */
+    [[nodiscard]] constexpr size_type max_size() const noexcept;
+    /** @return The number of elements contained in the set */
+    [[nodiscard]] size_type size() const noexcept;
+    /** @return true if the set contains no element */
+    [[nodiscard]] bool empty() const noexcept;
+    /** @return true if the number of elements in the set equals max_size() */
+    [[nodiscard]] bool full() const noexcept;
+    /** @brief empties the set */
+    void clear();
+
+    /** @return the element contained at this index */
+    [[nodiscard]] void* at(size_type a_Index);
+    /** @return the element contained at this index */
+    [[nodiscard]] const void* at(size_type a_Index) const;
+    /** @return *UNCHECKED* the element contained at this index */
+    [[nodiscard]] void* operator[](size_type a_Index) noexcept;
+    /** @return *UNCHECKED* the element contained at this index */
+    [[nodiscard]] const void* operator[](size_type a_Index) const noexcept;
+
+    /**
+    * @brief Inserts a default constructed element at the specified index,
+    * replaces the current element if it already exists
+    * @return the newly created element
+    */
+    void* insert(size_type a_Index);
+    /** @brief Inserts a copy of a_Source at the specified index, see insert */
+    void* insert(size_type a_Index, const void* a_Source);
+    /** @brief Removes the element at the specified index */
+    void erase(size_type a_Index);
+    /** @return true if a value is attached to this index */
+    bool contains(size_type a_Index) const;
+    /** @return *UNCHECKED* true if a value is attached to this index */
+    [[nodiscard]] bool contains_unchecked(size_type a_Index) const noexcept;
+    /** @return the indice contained in the set, in dense order */
+    [[nodiscard]] sparse_set_span<const size_type> keys() const noexcept;
+    /** @return the packed elements, size() of them stride() bytes apart */
+    [[nodiscard]] void* data() noexcept;
+    /** @brief Calls a_Func(index, element) for each element in dense order */
+    template<typename Func>
+    void for_each(Func&& a_Func);
+
+private:
+    [[nodiscard]] std::byte* _element(size_type a_Pos) const noexcept;
+    void* _insert(size_type a_Index, const void* a_Source);
+
+    sparse_set_element_info _info;
+    size_t _stride;
+    std::byte* _elements;
+    size_type _size{ 0 };
+    std::array<size_type, Size> _sparse;
+    std::array<size_type, Size> _keys; //the index of each dense element
+};
+
+template<uint32_t Size>
+runtime_sparse_set<Size>::runtime_sparse_set(const sparse_set_element_info& a_Info)
+    : _info(a_Info)
+    , _stride((std::max<size_t>(a_Info.size, 1) + a_Info.alignment - 1) / a_Info.alignment * a_Info.alignment)
+    , _elements((std::byte*)::operator new(_stride * Size, std::align_val_t(a_Info.alignment)))
+{
+    _sparse.fill(max_size());
+}
+
+template<uint32_t Size>
+runtime_sparse_set<Size>::~runtime_sparse_set() {
+    clear();
+    ::operator delete(_elements, std::align_val_t(_info.alignment));
+}
+
+template<uint32_t Size>
+const sparse_set_element_info& runtime_sparse_set<Size>::info() const noexcept {
+    return _info;
+}
+
+template<uint32_t Size>
+size_t runtime_sparse_set<Size>::stride() const noexcept {
+    return _stride;
+}
+
+template<uint32_t Size>
+constexpr auto runtime_sparse_set<Size>::max_size() const noexcept -> size_type {
+    return Size;
+}
+
+template<uint32_t Size>
+auto runtime_sparse_set<Size>::size() const noexcept -> size_type {
+    return _size;
+}
+
+template<uint32_t Size>
+bool runtime_sparse_set<Size>::empty() const noexcept {
+    return _size == 0;
+}
+
+template<uint32_t Size>
+bool runtime_sparse_set<Size>::full() const noexcept {
+    return _size == max_size();
+}
+
+template<uint32_t Size>
+void runtime_sparse_set<Size>::clear() {
+    for (size_type pos = 0; pos < _size; ++pos) {
+        _sparse[_keys[pos]] = max_size();
+        if (_info.destroy != nullptr) _info.destroy(_element(pos));
+    }
+    _size = 0;
+}
+
+template<uint32_t Size>
+void* runtime_sparse_set<Size>::at(size_type a_Index) {
+    const auto pos = _sparse.at(a_Index);
+    if (pos == max_size()) throw std::out_of_range("runtime_sparse_set::at: no element at this index");
+    return _element(pos);
+}
+
+template<uint32_t Size>
+const void* runtime_sparse_set<Size>::at(size_type a_Index) const {
+    const auto pos = _sparse.at(a_Index);
+    if (pos == max_size()) throw std::out_of_range("runtime_sparse_set::at: no element at this index");
+    return _element(pos);
+}
+
+template<uint32_t Size>
+void* runtime_sparse_set<Size>::operator[](size_type a_Index) noexcept {
+    return _element(_sparse[a_Index]);
+}
+
+template<uint32_t Size>
+const void* runtime_sparse_set<Size>::operator[](size_type a_Index) const noexcept {
+    return _element(_sparse[a_Index]);
+}
+
+template<uint32_t Size>
+void* runtime_sparse_set<Size>::insert(size_type a_Index) {
+    return _insert(a_Index, nullptr);
+}
+
+template<uint32_t Size>
+void* runtime_sparse_set<Size>::insert(size_type a_Index, const void* a_Source) {
+    return _insert(a_Index, a_Source);
+}
+
+template<uint32_t Size>
+void runtime_sparse_set<Size>::erase(size_type a_Index) {
+    if (empty() || !contains(a_Index)) return;
+    _size--;
+    const size_type currPos = _sparse[a_Index];
+    const size_type lastIndex = _keys[_size];
+    if (_info.destroy != nullptr) _info.destroy(_element(currPos));
+    if (currPos != _size) { //crush current data with last data
+        if (_info.relocate != nullptr) _info.relocate(_element(currPos), _element(_size));
+        else std::memcpy(_element(currPos), _element(_size), _info.size);
+    }
+    _keys[currPos] = lastIndex;
+    _sparse[lastIndex] = currPos;
+    _sparse[a_Index] = max_size();
+}
+
+template<uint32_t Size>
+bool runtime_sparse_set<Size>::contains(size_type a_Index) const {
+    //if a_Index is out of bound we should crash here
+    return _sparse.at(a_Index) != max_size();
+}
+
+template<uint32_t Size>
+bool runtime_sparse_set<Size>::contains_unchecked(size_type a_Index) const noexcept {
+    return _sparse[a_Index] != max_size();
+}
+
+template<uint32_t Size>
+auto runtime_sparse_set<Size>::keys() const noexcept -> sparse_set_span<const size_type> {
+    return { _keys.data(), _size };
+}
+
+template<uint32_t Size>
+void* runtime_sparse_set<Size>::data() noexcept {
+    return _elements;
+}
+
+template<uint32_t Size>
+template<typename Func>
+void runtime_sparse_set<Size>::for_each(Func&& a_Func) {
+    for (size_type pos = 0; pos < _size; ++pos) a_Func(_keys[pos], (void*)_element(pos));
+}
+
+template<uint32_t Size>
+std::byte* runtime_sparse_set<Size>::_element(size_type a_Pos) const noexcept {
+    return _elements + a_Pos * _stride;
+}
+
+template<uint32_t Size>
+void* runtime_sparse_set<Size>::_insert(size_type a_Index, const void* a_Source) {
+    size_type pos = _sparse.at(a_Index);
+    if (pos != max_size()) { //just replace the element
+        if (_info.destroy != nullptr) _info.destroy(_element(pos));
+    }
+    else {
+        if (full()) throw std::out_of_range("runtime_sparse_set::insert: the set is full");
+        pos = _size;
+    }
+    const auto element = _element(pos);
+    if (a_Source == nullptr && _info.construct != nullptr) _info.construct(element);
+    else if (a_Source == nullptr) std::memset(element, 0, _info.size);
+    else if (_info.copy != nullptr) _info.copy(element, a_Source);
+    else std::memcpy(element, a_Source, _info.size);
+    if (pos == _size) {
+        _sparse[a_Index] = pos;
+        _keys[pos] = a_Index;
+        _size++;
+    }
+    return element;
+}
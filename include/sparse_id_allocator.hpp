@@ -0,0 +1,173 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include <sparse_set.hpp>
+
+////////////////////////////////////////////////////////////////////////////////
+// Class declarations
+////////////////////////////////////////////////////////////////////////////////
+/**
+* @brief Allocates ids in [0, Size) using the sparse_set scheme:
+* the dense array holds the alive ids, the sparse slot of an alive id holds its
+* dense position and the slots of destroyed ids form a free list, each holding
+* the next free slot. Creating and destroying an id is O(1) and allocates nothing.
+* With GenerationBits the upper bits of an id count how many times its slot was
+* recycled, so ids kept after their destruction are not mistaken for new ones.
+* Use index_of(id) to index a sparse_set of the same Size.
+*/
+template<uint32_t Size, uint32_t GenerationBits = 0>
+class sparse_id_allocator {
+public:
+    using size_type = decltype(Size);
+    using id_type = uint32_t;
+    static constexpr uint32_t index_bits = 32 - GenerationBits;
+    static_assert(GenerationBits < 32, "at least one bit is needed for the index");
+    static_assert(index_bits == 32 || Size < (uint64_t(1) << index_bits), "Size doesn't fit in the index bits");
+
+    /** @return The maximum number of ids alive at once */
+    [[nodiscard]] constexpr size_type max_size() const noexcept;
+    /** @return The number of alive ids */
+    [[nodiscard]] constexpr size_type size() const noexcept;
+    /** @return true if no id is alive */
+    [[nodiscard]] constexpr bool empty() const noexcept;
+    /** @return true if no id can be created */
+    [[nodiscard]] constexpr bool full() const noexcept;
+    /** @brief Destroys every alive id, generations are bumped */
+    constexpr void clear() noexcept;
+
+    /** @return a new id, reusing the last destroyed slot first */
+    constexpr id_type create();
+    /** @brief Creates a_Count ids at once, writing them to a_Out. Throws before creating any if they don't fit */
+    constexpr void create_many(size_type a_Count, id_type* a_Out);
+    /** @brief Destroys an id, ids that aren't alive are ignored */
+    constexpr void destroy(id_type a_Id) noexcept;
+    /** @brief Destroys many ids at once, ids that aren't alive are ignored */
+    constexpr void destroy_many(const id_type* a_Ids, size_type a_Count) noexcept;
+
+    /** @return true if a_Id was created and not destroyed since, with the same generation */
+    [[nodiscard]] constexpr bool alive(id_type a_Id) const noexcept;
+    /** @return the alive ids, in dense order */
+    [[nodiscard]] constexpr sparse_set_span<const id_type> ids() const noexcept;
+
+    /** @return the slot of a_Id, the key to use in a sparse_set */
+    [[nodiscard]] static constexpr size_type index_of(id_type a_Id) noexcept;
+    /** @return the number of times the slot of a_Id was recycled before it was created, modulo 2^GenerationBits */
+    [[nodiscard]] static constexpr uint32_t generation_of(id_type a_Id) noexcept;
+
+private:
+    static constexpr id_type index_mask = index_bits == 32 ? ~id_type(0) : (id_type(1) << (index_bits % 32)) - 1;
+    static constexpr id_type _make(uint32_t a_Generation, size_type a_Index) noexcept;
+    constexpr void _destroy(id_type a_Id) noexcept;
+
+    size_type _size{ 0 };
+    size_type _next{ 0 }; //slots below were used at least once
+    size_type _free{ Size }; //last destroyed slot, Size if none
+    std::array<id_type, Size> _sparse; //dense position if alive, generation and next free slot otherwise
+    std::array<id_type, Size> _dense; //the alive ids
+};
+
+template<uint32_t Size, uint32_t GenerationBits>
+constexpr auto sparse_id_allocator<Size, GenerationBits>::max_size() const noexcept -> size_type {
+    return Size;
+}
+
+template<uint32_t Size, uint32_t GenerationBits>
+constexpr auto sparse_id_allocator<Size, GenerationBits>::size() const noexcept -> size_type {
+    return _size;
+}
+
+template<uint32_t Size, uint32_t GenerationBits>
+constexpr bool sparse_id_allocator<Size, GenerationBits>::empty() const noexcept {
+    return _size == 0;
+}
+
+template<uint32_t Size, uint32_t GenerationBits>
+constexpr bool sparse_id_allocator<Size, GenerationBits>::full() const noexcept {
+    return _size == max_size();
+}
+
+template<uint32_t Size, uint32_t GenerationBits>
+constexpr void sparse_id_allocator<Size, GenerationBits>::clear() noexcept {
+    while (_size > 0) _destroy(_dense[_size - 1]);
+}
+
+template<uint32_t Size, uint32_t GenerationBits>
+constexpr auto sparse_id_allocator<Size, GenerationBits>::create() -> id_type {
+    if (full()) throw std::out_of_range("sparse_id_allocator::create: no id left");
+    id_type id;
+    if (_free != max_size()) { //pop the free list, the slot holds the next one and its generation
+        const auto entry = _sparse[_free];
+        id = _make(generation_of(entry), _free);
+        _free = index_of(entry);
+    }
+    else id = _make(0, _next++);
+    _sparse[index_of(id)] = _size;
+    _dense[_size++] = id;
+    return id;
+}
+
+template<uint32_t Size, uint32_t GenerationBits>
+constexpr void sparse_id_allocator<Size, GenerationBits>::create_many(size_type a_Count, id_type* a_Out) {
+    if (a_Count > max_size() - _size) throw std::out_of_range("sparse_id_allocator::create_many: not enough ids left");
+    size_type i = 0;
+    for (; i < a_Count && _free != max_size(); ++i) a_Out[i] = create();
+    for (; i < a_Count; ++i) { //the free list is empty, new slots are contiguous
+        const id_type id = _make(0, _next++);
+        _sparse[index_of(id)] = _size;
+        _dense[_size++] = id;
+        a_Out[i] = id;
+    }
+}
+
+template<uint32_t Size, uint32_t GenerationBits>
+constexpr void sparse_id_allocator<Size, GenerationBits>::destroy(id_type a_Id) noexcept {
+    if (alive(a_Id)) _destroy(a_Id);
+}
+
+template<uint32_t Size, uint32_t GenerationBits>
+constexpr void sparse_id_allocator<Size, GenerationBits>::destroy_many(const id_type* a_Ids, size_type a_Count) noexcept {
+    for (size_type i = 0; i < a_Count; ++i) destroy(a_Ids[i]);
+}
+
+template<uint32_t Size, uint32_t GenerationBits>
+constexpr bool sparse_id_allocator<Size, GenerationBits>::alive(id_type a_Id) const noexcept {
+    //free slots hold a free list link, which never leads to a dense slot holding a_Id
+    const auto index = index_of(a_Id);
+    return index < _next && _sparse[index] < _size && _dense[_sparse[index]] == a_Id;
+}
+
+template<uint32_t Size, uint32_t GenerationBits>
+constexpr auto sparse_id_allocator<Size, GenerationBits>::ids() const noexcept -> sparse_set_span<const id_type> {
+    return { _dense.data(), _size };
+}
+
+template<uint32_t Size, uint32_t GenerationBits>
+constexpr auto sparse_id_allocator<Size, GenerationBits>::index_of(id_type a_Id) noexcept -> size_type {
+    return a_Id & index_mask;
+}
+
+template<uint32_t Size, uint32_t GenerationBits>
+constexpr uint32_t sparse_id_allocator<Size, GenerationBits>::generation_of(id_type a_Id) noexcept {
+    if constexpr (GenerationBits == 0) return 0;
+    else return a_Id >> index_bits;
+}
+
+template<uint32_t Size, uint32_t GenerationBits>
+constexpr auto sparse_id_allocator<Size, GenerationBits>::_make(uint32_t a_Generation, size_type a_Index) noexcept -> id_type {
+    if constexpr (GenerationBits == 0) return a_Index;
+    else return (a_Generation << index_bits) | a_Index;
+}
+
+template<uint32_t Size, uint32_t GenerationBits>
+constexpr void sparse_id_allocator<Size, GenerationBits>::_destroy(id_type a_Id) noexcept {
+    const auto index = index_of(a_Id);
+    const auto pos = _sparse[index];
+    const auto last = _dense[--_size];
+    _dense[pos] = last; //crush the destroyed id with the last one
+    _sparse[index_of(last)] = pos;
+    //the slot joins the free list, remembering the generation of its next id
+    _sparse[index] = _make(generation_of(a_Id) + 1, _free);
+    _free = index;
+}
@@ -3,32 +3,904 @@
 ////////////////////////////////////////////////////////////////////////////////
 // Includes
 ////////////////////////////////////////////////////////////////////////////////
+#include <cassert>
 #include <cstring>
 #include <cstdint>
+#include <cstddef>
+#include <algorithm>
 #include <array>
+#include <iterator>
 #include <memory>
+#include <stdexcept>
+#include <tuple>
 #include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+//C++20 makes destructors, std::construct_at and std::destroy_at usable in constant evaluation
+#if (defined(_MSVC_LANG) ? _MSVC_LANG : __cplusplus) >= 202002L
+#define SPARSE_SET_CONSTEXPR20 constexpr
+#else
+#define SPARSE_SET_CONSTEXPR20 inline
+#endif
+
+//MSVC ignores SPARSE_SET_NO_UNIQUE_ADDRESS and only honors its own spelling
+#if defined(_MSC_VER)
+#define SPARSE_SET_NO_UNIQUE_ADDRESS [[msvc::no_unique_address]]
+#else
+#define SPARSE_SET_NO_UNIQUE_ADDRESS [[no_unique_address]]
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// Helpers
+////////////////////////////////////////////////////////////////////////////////
+namespace sparse_set_detail {
+inline int popcount(uint64_t a_Bits) noexcept {
+#if defined(_MSC_VER)
+    return int(__popcnt64(a_Bits));
+#else
+    return __builtin_popcountll(a_Bits);
+#endif
+}
+
+/** @brief Hints the CPU to bring the cache line holding a_Address closer */
+inline void prefetch(const void* a_Address) noexcept {
+#if defined(_MSC_VER)
+    _mm_prefetch((const char*)a_Address, _MM_HINT_T0);
+#else
+    __builtin_prefetch(a_Address);
+#endif
+}
+
+/** @return true when called during constant evaluation, always false before C++20 */
+constexpr bool is_constant_evaluated() noexcept {
+#if (defined(_MSVC_LANG) ? _MSVC_LANG : __cplusplus) >= 202002L
+    return std::is_constant_evaluated();
+#else
+    return false;
+#endif
+}
+
+#ifndef NDEBUG
+/**
+* @brief Debug builds register each set walked by for_each on the current thread
+* for the lifetime of the guard, so erasing from it can be reported.
+*/
+class iteration_guard {
+public:
+    SPARSE_SET_CONSTEXPR20 explicit iteration_guard(const void* a_Set) noexcept : _set(a_Set) {
+        if (!is_constant_evaluated()) {
+            _previous = _top();
+            _top() = this;
+        }
+    }
+    iteration_guard(const iteration_guard&) = delete;
+    iteration_guard& operator=(const iteration_guard&) = delete;
+    SPARSE_SET_CONSTEXPR20 ~iteration_guard() {
+        if (!is_constant_evaluated()) _top() = _previous;
+    }
+    /** @return true if a_Set is being walked on this thread */
+    static bool iterating(const void* a_Set) noexcept {
+        for (auto guard = _top(); guard != nullptr; guard = guard->_previous)
+            if (guard->_set == a_Set) return true;
+        return false;
+    }
+
+private:
+    static const iteration_guard*& _top() noexcept {
+        thread_local const iteration_guard* top = nullptr;
+        return top;
+    }
+    const void* _set;
+    const iteration_guard* _previous{ nullptr };
+};
+#endif
+
+/** @brief std::construct_at, falling back to placement new before C++20 */
+template<typename Type, typename ...Args>
+constexpr Type* construct_at(Type* a_Address, Args&&... a_Args) {
+#if (defined(_MSVC_LANG) ? _MSVC_LANG : __cplusplus) >= 202002L
+    return std::construct_at(a_Address, std::forward<Args>(a_Args)...);
+#else
+    return new(a_Address) Type(std::forward<Args>(a_Args)...);
+#endif
+}
+
+/** @brief Exchanges the Bytes bytes at a_Left and a_Right, which must not overlap */
+template<size_t Bytes>
+inline void swap_bytes(void* a_Left, void* a_Right) noexcept {
+    std::byte tmp[Bytes];
+    std::memcpy(tmp, a_Left, Bytes);
+    std::memcpy(a_Left, a_Right, Bytes);
+    std::memcpy(a_Right, tmp, Bytes);
+}
+
+/**
+* @brief Moves the object at a_From to the unoccupied a_To, a_From is left unoccupied.
+* Trivially copyable objects are moved as bytes outside of constant evaluation.
+*/
+template<typename Type>
+constexpr void relocate_at(Type* a_From, Type* a_To) noexcept {
+    if (std::is_trivially_copyable_v<Type> && !is_constant_evaluated()) std::memmove((void*)a_To, (const void*)a_From, sizeof(Type));
+    else {
+        sparse_set_detail::construct_at(a_To, std::move(*a_From));
+        std::destroy_at(a_From);
+    }
+}
+
+/** @brief Exchanges the objects at a_Left and a_Right, see relocate_at */
+template<typename Type>
+constexpr void swap_at(Type* a_Left, Type* a_Right) noexcept {
+    if (std::is_trivially_copyable_v<Type> && !is_constant_evaluated()) swap_bytes<sizeof(Type)>((void*)a_Left, (void*)a_Right);
+    else {
+        Type tmp(std::move(*a_Left));
+        std::destroy_at(a_Left);
+        sparse_set_detail::construct_at(a_Left, std::move(*a_Right));
+        std::destroy_at(a_Right);
+        sparse_set_detail::construct_at(a_Right, std::move(tmp));
+    }
+}
+
+/** @brief Calls a_Undo when leaving the scope unless dismissed, to roll back a change an exception interrupted */
+template<typename Undo>
+class rollback {
+public:
+    constexpr explicit rollback(Undo a_Undo) noexcept : _undo(std::move(a_Undo)) {}
+    rollback(const rollback&) = delete;
+    rollback& operator=(const rollback&) = delete;
+    SPARSE_SET_CONSTEXPR20 ~rollback() {
+        if (_armed) _undo();
+    }
+    constexpr void dismiss() noexcept { _armed = false; }
+
+private:
+    Undo _undo;
+    bool _armed{ true };
+};
+
+/** @return the index of the lowest set bit, a_Bits must not be 0 */
+inline int countr_zero(uint64_t a_Bits) noexcept {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, a_Bits);
+    return int(index);
+#else
+    return __builtin_ctzll(a_Bits);
+#endif
+}
+}
 
 ////////////////////////////////////////////////////////////////////////////////
 // Class declarations
 ////////////////////////////////////////////////////////////////////////////////
+/** @brief How a sparse_set stores its elements */
+enum class sparse_set_storage {
+    automatic,  //tag for empty elements, indirect for elements larger than Policy::indirect_threshold, direct otherwise
+    direct,     //elements live in the dense array, erasing moves the last element
+    indirect,   //the dense array holds handles into a pool of slabs allocated as the set grows
+    paged,      //elements live in fixed size pages allocated as the set grows, growing never moves elements
+    soa,        //each field of the elements gets its own column, see sparse_set_fields
+    aosoa,      //like soa but fields are grouped by blocks of Policy::block_size elements
+    tag         //nothing is stored, for empty trivially destructible elements
+};
+
+/** @brief Element type of sparse_set<void, Size> */
+struct sparse_set_tag {};
+
+/** @brief What erasing an element does to the dense array */
+enum class sparse_set_erase {
+    swap,       //the last element is moved into the hole, keeps the dense array packed
+    tombstone,  //the hole is kept and reused by later insertions until compact() is called, elements never move
+    ordered     //the elements after the hole are shifted down, dense order stays insertion order
+};
+
+/** @brief What at, contains, insert and erase do with an index out of bound */
+enum class sparse_set_check {
+    exception,  //throw std::out_of_range
+    assertion,  //assert in debug builds, nothing in release builds
+    none,       //nothing, out of bound indice are undefined behavior
+    mask        //wrap the index with Size - 1, branch-free, Size must be a power of two
+};
+
+/** @brief How a sparse_set finds the dense position of an index */
+enum class sparse_set_lookup {
+    sparse, //an array of Size dense positions, 4 bytes per possible index
+    rank    //an occupancy bitset with per-word prefix counts, elements are kept sorted by index
+};
+
+namespace sparse_set_detail {
+struct any_field {
+    template<typename Type>
+    operator Type() const;
+};
+
+template<typename Type, typename Void, typename ...Fields>
+struct is_brace_constructible : std::false_type {};
+template<typename Type, typename ...Fields>
+struct is_brace_constructible<Type, std::void_t<decltype(Type{ { std::declval<Fields>() }... })>, Fields...> : std::true_type {};
+
+/** @return the number of fields of an aggregate, each initializer is braced to defeat brace elision */
+template<typename Type, typename ...Fields>
+constexpr size_t field_count() noexcept {
+    if constexpr (sizeof...(Fields) < 8 && is_brace_constructible<Type, void, Fields..., any_field>::value)
+        return field_count<Type, Fields..., any_field>();
+    else return sizeof...(Fields);
+}
+
+/** @return a tuple of references to the fields of an aggregate, using structured bindings */
+template<typename Type>
+constexpr auto tie_fields(Type& a_Value) noexcept {
+    constexpr auto count = field_count<std::remove_const_t<Type>>();
+    static_assert(count > 0 && count <= 8, "cannot reflect this type, specialize sparse_set_fields");
+    if constexpr (count == 1) { auto& [f0] = a_Value; return std::tie(f0); }
+    else if constexpr (count == 2) { auto& [f0, f1] = a_Value; return std::tie(f0, f1); }
+    else if constexpr (count == 3) { auto& [f0, f1, f2] = a_Value; return std::tie(f0, f1, f2); }
+    else if constexpr (count == 4) { auto& [f0, f1, f2, f3] = a_Value; return std::tie(f0, f1, f2, f3); }
+    else if constexpr (count == 5) { auto& [f0, f1, f2, f3, f4] = a_Value; return std::tie(f0, f1, f2, f3, f4); }
+    else if constexpr (count == 6) { auto& [f0, f1, f2, f3, f4, f5] = a_Value; return std::tie(f0, f1, f2, f3, f4, f5); }
+    else if constexpr (count == 7) { auto& [f0, f1, f2, f3, f4, f5, f6] = a_Value; return std::tie(f0, f1, f2, f3, f4, f5, f6); }
+    else { auto& [f0, f1, f2, f3, f4, f5, f6, f7] = a_Value; return std::tie(f0, f1, f2, f3, f4, f5, f6, f7); }
+}
+}
+
+/**
+* @brief Describes the fields soa and aosoa storage split Type into.
+* The default reflects simple aggregates of up to 8 fields with structured bindings,
+* specialize it with a static tie(Type&) and tie(const Type&) returning a
+* std::tuple of references to the fields to override it.
+*/
+template<typename Type>
+struct sparse_set_fields {
+    static constexpr auto tie(Type& a_Value) noexcept { return sparse_set_detail::tie_fields(a_Value); }
+    static constexpr auto tie(const Type& a_Value) noexcept { return sparse_set_detail::tie_fields(a_Value); }
+};
+
+/**
+* @brief Proxy reference to an element split in columns.
+* Converts to Type, assigning a Type writes every field, get<I>() reaches a single field.
+*/
+template<typename Type, typename Fields>
+class sparse_set_field_reference {
+public:
+    constexpr explicit sparse_set_field_reference(Fields a_Fields) noexcept : _fields(a_Fields) {}
+    constexpr sparse_set_field_reference(const sparse_set_field_reference&) noexcept = default;
+
+    /** @return a ref to the field I of the element */
+    template<size_t I>
+    [[nodiscard]] constexpr auto& get() const noexcept { return std::get<I>(_fields); }
+    /** @return a copy of the element, gathered from its fields */
+    [[nodiscard]] constexpr operator Type() const {
+        Type value{};
+        sparse_set_fields<Type>::tie(value) = _fields;
+        return value;
+    }
+    /** @brief Scatters a_Value into the fields of the element */
+    constexpr sparse_set_field_reference& operator=(const Type& a_Value) {
+        _fields = sparse_set_fields<Type>::tie(a_Value);
+        return *this;
+    }
+    constexpr sparse_set_field_reference& operator=(const sparse_set_field_reference& a_Other) {
+        _fields = a_Other._fields;
+        return *this;
+    }
+
+private:
+    Fields _fields;
+};
+
+namespace sparse_set_detail {
+template<typename Type, uint32_t Size, uint32_t BlockSize, typename Fields = decltype(sparse_set_fields<Type>::tie(std::declval<Type&>()))>
+class field_storage;
+
+/**
+* @brief Each field of the elements is stored in place, in blocks of BlockSize
+* elements where every field gets its own contiguous run (AoSoA).
+* BlockSize == Size gives one column per field (SoA).
+* Relocating an element relocates each field, see relocate_at.
+*/
+template<typename Type, uint32_t Size, uint32_t BlockSize, typename ...Fields>
+class field_storage<Type, Size, BlockSize, std::tuple<Fields&...>> {
+public:
+    static_assert(BlockSize == Size || (BlockSize & (BlockSize - 1)) == 0, "the block size must be a power of two");
+    using value_type = Type;
+    using reference = sparse_set_field_reference<Type, std::tuple<Fields&...>>;
+    using const_reference = sparse_set_field_reference<Type, std::tuple<const Fields&...>>;
+    using block_type = std::tuple<Fields*...>;
+    /** @brief Elements are split in blocks of block_size starting at multiples of block_size */
+    static constexpr uint32_t block_size = BlockSize;
+
+    [[nodiscard]] reference get(uint32_t a_Pos) noexcept { return _get<reference>(a_Pos, std::index_sequence_for<Fields...>{}); }
+    [[nodiscard]] const_reference get(uint32_t a_Pos) const noexcept { return _get<const_reference>(a_Pos, std::index_sequence_for<Fields...>{}); }
+    template<typename ...Args>
+    reference construct(uint32_t a_Pos, Args&&... a_Args) {
+        //build the element then scatter its fields
+        auto value = [&] {
+            if constexpr (std::is_constructible_v<value_type, Args...>) return value_type(std::forward<Args>(a_Args)...);
+            else return value_type{ std::forward<Args>(a_Args)... };
+        }();
+        _scatter(a_Pos, sparse_set_fields<Type>::tie(value), std::index_sequence_for<Fields...>{});
+        return get(a_Pos);
+    }
+    void destroy(uint32_t a_Pos) noexcept {
+        std::apply([=](auto&... a_Fields) { (std::destroy_at(_field(a_Fields, a_Pos)), ...); }, _block(a_Pos));
+    }
+    /** @brief Moves the element at a_From to the unoccupied a_To, a_From is left unoccupied */
+    void relocate(uint32_t a_From, uint32_t a_To) noexcept {
+        auto& from = _block(a_From);
+        auto& to = _block(a_To);
+        _relocate(from, _offset(a_From), to, _offset(a_To), std::index_sequence_for<Fields...>{});
+    }
+    /** @brief Exchanges the elements at a_Left and a_Right */
+    void swap(uint32_t a_Left, uint32_t a_Right) noexcept {
+        _swap(_block(a_Left), _offset(a_Left), _block(a_Right), _offset(a_Right), std::index_sequence_for<Fields...>{});
+    }
+    void prefetch(uint32_t a_Pos) const noexcept {
+        const auto pos = std::min(a_Pos, Size - 1);
+        std::apply([=](auto&... a_Fields) { (sparse_set_detail::prefetch(_field(a_Fields, pos)), ...); }, _block(pos));
+    }
+    /** @return the column holding the field I of every element, only with BlockSize == Size */
+    template<size_t I>
+    [[nodiscard]] auto column() noexcept {
+        static_assert(BlockSize == Size, "columns only exist when there is a single block");
+        return _field(std::get<I>(_blocks[0]), 0);
+    }
+    /** @return pointers to each field of the block starting at a_Pos */
+    [[nodiscard]] block_type block(uint32_t a_Pos) noexcept {
+        return std::apply([=](auto&... a_Fields) { return block_type(_field(a_Fields, a_Pos)...); }, _block(a_Pos));
+    }
+
+private:
+#pragma warning(push)
+#pragma warning(disable : 26495) //variables are left uninitialized on purpose
+    template<typename Field>
+    struct slot {
+        alignas(Field) std::byte data[sizeof(Field)];
+    };
+#pragma warning(pop)
+    template<typename Field>
+    using run_type = std::array<slot<Field>, BlockSize>;
+    using storage_block = std::tuple<run_type<Fields>...>;
+    static constexpr uint32_t _offset(uint32_t a_Pos) noexcept { return BlockSize == Size ? a_Pos : a_Pos % BlockSize; }
+    storage_block& _block(uint32_t a_Pos) noexcept { return _blocks[BlockSize == Size ? 0 : a_Pos / BlockSize]; }
+    const storage_block& _block(uint32_t a_Pos) const noexcept { return _blocks[BlockSize == Size ? 0 : a_Pos / BlockSize]; }
+    template<typename Field>
+    static Field* _field(run_type<Field>& a_Run, uint32_t a_Pos) noexcept { return (Field*)a_Run[_offset(a_Pos)].data; }
+    template<typename Field>
+    static const Field* _field(const run_type<Field>& a_Run, uint32_t a_Pos) noexcept { return (const Field*)a_Run[_offset(a_Pos)].data; }
+    template<typename Reference, size_t ...I>
+    Reference _get(uint32_t a_Pos, std::index_sequence<I...>) const noexcept {
+        auto& block = _block(a_Pos);
+        return Reference({ *(Fields*)_field(std::get<I>(block), a_Pos)... });
+    }
+    template<typename Tie, size_t ...I>
+    void _scatter(uint32_t a_Pos, Tie a_Fields, std::index_sequence<I...>) {
+        auto& block = _block(a_Pos);
+        (new(std::get<I>(block)[_offset(a_Pos)].data) Fields(std::move(std::get<I>(a_Fields))), ...);
+    }
+    template<size_t ...I>
+    static void _relocate(storage_block& a_From, uint32_t a_FromOffset, storage_block& a_To, uint32_t a_ToOffset, std::index_sequence<I...>) noexcept {
+        (sparse_set_detail::relocate_at((Fields*)std::get<I>(a_From)[a_FromOffset].data, (Fields*)std::get<I>(a_To)[a_ToOffset].data), ...);
+    }
+    template<size_t ...I>
+    static void _swap(storage_block& a_Left, uint32_t a_LeftOffset, storage_block& a_Right, uint32_t a_RightOffset, std::index_sequence<I...>) noexcept {
+        (sparse_set_detail::swap_at((Fields*)std::get<I>(a_Left)[a_LeftOffset].data, (Fields*)std::get<I>(a_Right)[a_RightOffset].data), ...);
+    }
+    std::array<storage_block, (Size + BlockSize - 1) / BlockSize> _blocks;
+};
+}
+
+namespace sparse_set_detail {
+/**
+* @brief Elements are stored in place, indexed by their dense position.
+* Relocating an element moves its bytes when it is trivially copyable and
+* outside of constant evaluation, it is move constructed otherwise.
+*/
+template<typename Type, uint32_t Size>
+class direct_storage {
+public:
+    using value_type = Type;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+
+    [[nodiscard]] constexpr value_type& get(uint32_t a_Pos) noexcept { return _slots[a_Pos].value; }
+    [[nodiscard]] constexpr const value_type& get(uint32_t a_Pos) const noexcept { return _slots[a_Pos].value; }
+    template<typename ...Args>
+    constexpr value_type& construct(uint32_t a_Pos, Args&&... a_Args) {
+        return *sparse_set_detail::construct_at(&_slots[a_Pos].value, std::forward<Args>(a_Args)...);
+    }
+    constexpr void destroy(uint32_t a_Pos) noexcept(std::is_nothrow_destructible_v<value_type>) {
+        std::destroy_at(&get(a_Pos));
+    }
+    /** @brief Moves the element at a_From to the unoccupied a_To, a_From is left unoccupied */
+    constexpr void relocate(uint32_t a_From, uint32_t a_To) noexcept {
+        sparse_set_detail::relocate_at(&_slots[a_From].value, &_slots[a_To].value);
+    }
+    /** @brief Exchanges the elements at a_Left and a_Right */
+    constexpr void swap(uint32_t a_Left, uint32_t a_Right) noexcept {
+        sparse_set_detail::swap_at(&_slots[a_Left].value, &_slots[a_Right].value);
+    }
+    void prefetch(uint32_t a_Pos) const noexcept {
+        sparse_set_detail::prefetch(_slots.data() + std::min(a_Pos, Size - 1));
+    }
+    /** @brief Elements are contiguous by runs of page_size starting at multiples of page_size */
+    static constexpr uint32_t page_size = Size;
+    [[nodiscard]] constexpr value_type* data(uint32_t a_Pos) noexcept { return &get(a_Pos); }
+
+private:
+#pragma warning(push)
+#pragma warning(disable : 26495) //variables are left uninitialized on purpose
+    struct vacant {};
+    union slot {
+        //vacant is active until an element is constructed, initializing it emits no code
+        constexpr slot() noexcept : none() {}
+        SPARSE_SET_CONSTEXPR20 ~slot() {}
+        vacant none;
+        value_type value;
+    };
+#pragma warning(pop)
+    std::array<slot, Size> _slots;
+};
+
+/**
+* @brief Elements are stored in place in pages of PageSize elements, a page is
+* allocated when the set first grows into it and kept until destruction.
+* Relocating an element moves it, see relocate_at, growing never does.
+*/
+template<typename Type, uint32_t Size, uint32_t PageSize>
+class paged_storage {
+public:
+    using value_type = Type;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    static_assert(PageSize != 0 && (PageSize & (PageSize - 1)) == 0, "page size must be a power of two");
+
+    [[nodiscard]] value_type& get(uint32_t a_Pos) noexcept { return *(value_type*)_slot(a_Pos).data; }
+    [[nodiscard]] const value_type& get(uint32_t a_Pos) const noexcept { return *(const value_type*)_slot(a_Pos).data; }
+    template<typename ...Args>
+    value_type& construct(uint32_t a_Pos, Args&&... a_Args) {
+        ensure(a_Pos);
+        return *new(_slot(a_Pos).data) value_type(std::forward<Args>(a_Args)...);
+    }
+    /** @brief Allocates the page holding a_Pos if needed, before relocating to a slot never constructed */
+    void ensure(uint32_t a_Pos) {
+        auto& page = _pages[a_Pos / PageSize];
+        if (page == nullptr) page.reset(new struct page);
+    }
+    void destroy(uint32_t a_Pos) noexcept(std::is_nothrow_destructible_v<value_type>) {
+        std::destroy_at(&get(a_Pos));
+    }
+    /** @brief Moves the element at a_From to the unoccupied a_To, a_From is left unoccupied */
+    void relocate(uint32_t a_From, uint32_t a_To) noexcept {
+        sparse_set_detail::relocate_at(&get(a_From), (value_type*)_slot(a_To).data);
+    }
+    /** @brief Exchanges the elements at a_Left and a_Right */
+    void swap(uint32_t a_Left, uint32_t a_Right) noexcept {
+        sparse_set_detail::swap_at(&get(a_Left), &get(a_Right));
+    }
+    void prefetch(uint32_t a_Pos) const noexcept {
+        const auto& page = _pages[std::min(a_Pos, Size - 1) / PageSize];
+        if (page != nullptr) sparse_set_detail::prefetch(&page->slots[a_Pos % PageSize]);
+    }
+    /** @brief Elements are contiguous by runs of page_size starting at multiples of page_size */
+    static constexpr uint32_t page_size = PageSize;
+    [[nodiscard]] value_type* data(uint32_t a_Pos) noexcept { return &get(a_Pos); }
+
+private:
+    static constexpr uint32_t page_count = (Size + PageSize - 1) / PageSize;
+#pragma warning(push)
+#pragma warning(disable : 26495) //variables are left uninitialized on purpose
+    struct slot {
+        alignas(value_type) std::byte data[sizeof(value_type)];
+    };
+#pragma warning(pop)
+    struct page {
+        std::array<slot, PageSize> slots;
+    };
+    [[nodiscard]] slot& _slot(uint32_t a_Pos) const noexcept {
+        return _pages[a_Pos / PageSize]->slots[a_Pos % PageSize];
+    }
+    std::array<std::unique_ptr<page>, page_count> _pages;
+};
+
+/**
+* @brief Stores nothing, every element shares the same empty object
+*/
+template<typename Type>
+class tag_storage {
+public:
+    using value_type = Type;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    static_assert(std::is_empty_v<value_type> && std::is_trivially_destructible_v<value_type>,
+        "tag storage requires an empty trivially destructible type");
+
+    [[nodiscard]] constexpr value_type& get(uint32_t) noexcept { return _tag; }
+    [[nodiscard]] constexpr const value_type& get(uint32_t) const noexcept { return _tag; }
+    template<typename ...Args>
+    constexpr value_type& construct(uint32_t, Args&&... a_Args) {
+        return *sparse_set_detail::construct_at(&_tag, std::forward<Args>(a_Args)...);
+    }
+    constexpr void destroy(uint32_t) noexcept {}
+    constexpr void relocate(uint32_t, uint32_t) noexcept {}
+    constexpr void swap(uint32_t, uint32_t) noexcept {}
+    void prefetch(uint32_t) const noexcept {}
+
+private:
+    SPARSE_SET_NO_UNIQUE_ADDRESS value_type _tag;
+};
+
 /**
-* @brief sizeof(sparse_set) is at least sizeof(Type) * Size. Large sets should
-* therefore be allocated on the heap.
+* @brief The dense array holds 4 bytes handles into slabs of elements,
+* slabs are allocated when the set first grows into them and kept until destruction.
+* Relocating an element only moves its handle and elements never move in memory.
+*/
+template<typename Type, uint32_t Size>
+class indirect_storage {
+public:
+    using value_type = Type;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+
+    [[nodiscard]] value_type& get(uint32_t a_Pos) noexcept { return *(value_type*)_slot(_handles[a_Pos]).data; }
+    [[nodiscard]] const value_type& get(uint32_t a_Pos) const noexcept { return *(const value_type*)_slot(_handles[a_Pos]).data; }
+    template<typename ...Args>
+    value_type& construct(uint32_t a_Pos, Args&&... a_Args) {
+        const auto handle = _allocate();
+        try {
+            auto& value = *new(_slot(handle).data) value_type(std::forward<Args>(a_Args)...);
+            _handles[a_Pos] = handle;
+            return value;
+        }
+        catch (...) {
+            _release(handle);
+            throw;
+        }
+    }
+    void destroy(uint32_t a_Pos) noexcept(std::is_nothrow_destructible_v<value_type>) {
+        std::destroy_at(&get(a_Pos));
+        _release(_handles[a_Pos]);
+    }
+    /** @brief Moves the element at a_From to the unoccupied a_To, a_From is left unoccupied */
+    void relocate(uint32_t a_From, uint32_t a_To) noexcept {
+        _handles[a_To] = _handles[a_From];
+    }
+    /** @brief Exchanges the elements at a_Left and a_Right, only their handles move */
+    void swap(uint32_t a_Left, uint32_t a_Right) noexcept {
+        std::swap(_handles[a_Left], _handles[a_Right]);
+    }
+    void prefetch(uint32_t a_Pos) const noexcept {
+        const auto handle = _handles[std::min(a_Pos, Size - 1)];
+        if (handle < _next) sparse_set_detail::prefetch(&_slot(handle));
+    }
+
+private:
+    static constexpr uint32_t slab_size = 64;
+    static constexpr uint32_t slab_count = (Size + slab_size - 1) / slab_size;
+    static constexpr uint32_t no_handle = Size;
+#pragma warning(push)
+#pragma warning(disable : 26495) //variables are left uninitialized on purpose
+    struct slot {
+        //a released slot holds the next released handle
+        alignas(value_type) alignas(uint32_t) std::byte data[std::max(sizeof(value_type), sizeof(uint32_t))];
+    };
+#pragma warning(pop)
+    struct slab {
+        std::array<slot, slab_size> slots;
+    };
+    [[nodiscard]] slot& _slot(uint32_t a_Handle) const noexcept {
+        return _slabs[a_Handle / slab_size]->slots[a_Handle % slab_size];
+    }
+    uint32_t _allocate() {
+        if (_free != no_handle) {
+            const auto handle = _free;
+            std::memcpy(&_free, _slot(handle).data, sizeof(uint32_t));
+            return handle;
+        }
+        auto& slab = _slabs[_next / slab_size];
+        if (slab == nullptr) slab.reset(new struct slab);
+        return _next++;
+    }
+    void _release(uint32_t a_Handle) noexcept {
+        std::memcpy(_slot(a_Handle).data, &_free, sizeof(uint32_t));
+        _free = a_Handle;
+    }
+    std::array<uint32_t, Size> _handles{};
+    std::array<std::unique_ptr<slab>, slab_count> _slabs;
+    uint32_t _next{ 0 }; //first handle never allocated
+    uint32_t _free{ no_handle }; //last released handle
+};
+
+/** @brief Maps each index to its dense position, Size meaning absent */
+template<uint32_t Size>
+class sparse_index {
+public:
+    constexpr sparse_index() noexcept { _slots.fill(Size); }
+
+    [[nodiscard]] constexpr bool contains(uint32_t a_Index) const noexcept { return _slots[a_Index] != Size; }
+    [[nodiscard]] constexpr uint32_t find(uint32_t a_Index) const noexcept { return _slots[a_Index]; }
+    constexpr void attach(uint32_t a_Index, uint32_t a_Pos) noexcept { _slots[a_Index] = a_Pos; }
+    constexpr void detach(uint32_t a_Index) noexcept { _slots[a_Index] = Size; }
+    void prefetch(uint32_t a_Index) const noexcept { sparse_set_detail::prefetch(_slots.data() + std::min(a_Index, Size - 1)); }
+    /** @return the dense position of every index, for gathers */
+    [[nodiscard]] const uint32_t* data() const noexcept { return _slots.data(); }
+
+private:
+    std::array<uint32_t, Size> _slots;
+};
+
+/**
+* @brief Succinct index: one occupancy bit per index plus the number of bits
+* set in the previous words, the dense position of an index is its rank.
+* Positions are implied, so the dense array must be kept sorted by index.
+*/
+template<uint32_t Size>
+class rank_index {
+public:
+    static constexpr uint32_t word_count = (Size + 63) / 64;
+    using count_type = std::conditional_t<(Size < 0x10000), uint16_t, uint32_t>;
+
+    [[nodiscard]] bool contains(uint32_t a_Index) const noexcept { return (_bits[a_Index / 64] >> (a_Index % 64)) & 1; }
+    /** @return the number of indice lower than a_Index in the set */
+    [[nodiscard]] uint32_t rank(uint32_t a_Index) const noexcept {
+        const auto below = _bits[a_Index / 64] & ((uint64_t(1) << (a_Index % 64)) - 1);
+        return _prefix[a_Index / 64] + uint32_t(sparse_set_detail::popcount(below));
+    }
+    [[nodiscard]] uint32_t find(uint32_t a_Index) const noexcept { return contains(a_Index) ? rank(a_Index) : Size; }
+    /** @brief Marks a_Index as present, a_Pos must be its rank */
+    void attach(uint32_t a_Index, uint32_t) noexcept {
+        _bits[a_Index / 64] |= uint64_t(1) << (a_Index % 64);
+        for (auto word = a_Index / 64 + 1; word < word_count; ++word) ++_prefix[word];
+    }
+    void detach(uint32_t a_Index) noexcept {
+        _bits[a_Index / 64] &= ~(uint64_t(1) << (a_Index % 64));
+        for (auto word = a_Index / 64 + 1; word < word_count; ++word) --_prefix[word];
+    }
+    void prefetch(uint32_t a_Index) const noexcept { sparse_set_detail::prefetch(_bits.data() + std::min(a_Index, Size - 1) / 64); }
+
+private:
+    std::array<uint64_t, word_count> _bits{};
+    std::array<count_type, word_count> _prefix{};
+};
+
+/**
+* @brief Two level occupancy bitset, one bit per index and one summary bit per
+* 64 indice word, so ordered walks skip empty 64 and 4096 indice blocks.
+*/
+template<uint32_t Size>
+class occupancy {
+public:
+    static constexpr uint32_t word_count = (Size + 63) / 64;
+    static constexpr uint32_t summary_count = (word_count + 63) / 64;
+
+    void set(uint32_t a_Index) noexcept {
+        const auto word = a_Index / 64;
+        _bits[word] |= uint64_t(1) << (a_Index % 64);
+        _summary[word / 64] |= uint64_t(1) << (word % 64);
+    }
+    void reset(uint32_t a_Index) noexcept {
+        const auto word = a_Index / 64;
+        _bits[word] &= ~(uint64_t(1) << (a_Index % 64));
+        if (_bits[word] == 0) _summary[word / 64] &= ~(uint64_t(1) << (word % 64));
+    }
+    /** @brief Calls a_Func(index) for each set index in [a_First, a_Last), in ascending order */
+    template<typename Func>
+    void for_each(uint32_t a_First, uint32_t a_Last, Func&& a_Func) const {
+        a_Last = std::min(a_Last, Size);
+        if (a_First >= a_Last) return;
+        const uint32_t firstWord = a_First / 64, lastWord = (a_Last - 1) / 64;
+        for (uint32_t summary = firstWord / 64; summary <= lastWord / 64; ++summary) {
+            uint64_t words = _summary[summary];
+            if (summary == firstWord / 64) words &= ~uint64_t(0) << (firstWord % 64);
+            if (summary == lastWord / 64) words &= (uint64_t(2) << (lastWord % 64)) - 1;
+            for (; words != 0; words &= words - 1) {
+                const uint32_t word = summary * 64 + uint32_t(sparse_set_detail::countr_zero(words));
+                uint64_t bits = _bits[word];
+                if (word == firstWord) bits &= ~uint64_t(0) << (a_First % 64);
+                if (word == lastWord) bits &= (uint64_t(2) << ((a_Last - 1) % 64)) - 1;
+                for (; bits != 0; bits &= bits - 1)
+                    a_Func(word * 64 + uint32_t(sparse_set_detail::countr_zero(bits)));
+            }
+        }
+    }
+
+private:
+    std::array<uint64_t, word_count> _bits{};
+    std::array<uint64_t, summary_count> _summary{};
+};
+}
+
+/**
+* @brief Default sparse_set policy.
+* Derive from it and override the members you need to customize a set.
+*/
+struct sparse_set_policy {
+    /**
+    * @brief When true every insert, replace, erase and modify is stamped with
+    * the current epoch so deltas can be built with sparse_set::make_delta.
+    * Costs 2 epochs per possible index.
+    */
+    static constexpr bool track_changes = false;
+    /**
+    * @brief Type notified of insertions, replacements and erasures,
+    * see sparse_set_observer. void compiles every hook out.
+    */
+    using observer_type = void;
+    /**
+    * @brief How many indice ahead batched lookups prefetch sparse slots,
+    * elements are prefetched half as far ahead once their sparse slot arrived
+    */
+    static constexpr uint32_t prefetch_distance = 16;
+    /** @brief How elements are stored, see sparse_set_storage */
+    static constexpr sparse_set_storage storage = sparse_set_storage::automatic;
+    /** @brief Size in bytes above which automatic storage stores elements indirectly */
+    static constexpr size_t indirect_threshold = 256;
+    /** @brief Number of elements per page with paged storage, must be a power of two */
+    static constexpr uint32_t page_size = 1024;
+    /** @brief Number of elements per block with aosoa storage, must be a power of two, usually the SIMD width */
+    static constexpr uint32_t block_size = 8;
+    /** @brief What erasing does to the dense array, see sparse_set_erase */
+    static constexpr sparse_set_erase erase = sparse_set_erase::swap;
+    /** @brief How indice are mapped to dense positions, see sparse_set_lookup. rank suits small sets */
+    static constexpr sparse_set_lookup lookup = sparse_set_lookup::sparse;
+    /**
+    * @brief Maintains a two level occupancy bitset on insertion and erasure so
+    * for_each_ordered costs about one step per element. Implied by the rank lookup.
+    */
+    static constexpr bool ordered_iteration = false;
+    /** @brief Bounds checking of at, contains, insert and erase, see sparse_set_check */
+    static constexpr sparse_set_check check = sparse_set_check::exception;
+    /**
+    * @brief Splits the dense array into enabled then disabled elements, see sparse_set::disable.
+    * Iteration only visits enabled elements.
+    */
+    static constexpr bool partition = false;
+};
+
+/**
+* @brief CRTP base for sparse_set observers, every hook defaults to a no-op
+* and the batched hooks default to calling the single ones.
+* Hooks receive the set so they can read the element being notified.
+* on_insert and on_replace fire after construction, on_erase before destruction.
+*/
+template<typename Derived>
+struct sparse_set_observer {
+    template<typename Set> void on_insert(Set&, uint32_t) {}
+    template<typename Set> void on_replace(Set&, uint32_t) {}
+    template<typename Set> void on_erase(Set&, uint32_t) {}
+    template<typename Set> void on_insert_many(Set& a_Set, const uint32_t* a_Indice, uint32_t a_Count) {
+        for (uint32_t i = 0; i < a_Count; ++i) static_cast<Derived&>(*this).on_insert(a_Set, a_Indice[i]);
+    }
+    template<typename Set> void on_erase_many(Set& a_Set, const uint32_t* a_Indice, uint32_t a_Count) {
+        for (uint32_t i = 0; i < a_Count; ++i) static_cast<Derived&>(*this).on_erase(a_Set, a_Indice[i]);
+    }
+};
+
+/**
+* @brief The changes a set went through since a given epoch,
+* built by sparse_set::make_delta and consumed by sparse_set::apply_delta.
+*/
+template<typename Type>
+struct sparse_set_delta {
+    using value_type = Type;
+    using size_type = uint32_t;
+    using epoch_type = uint32_t;
+
+    /** @brief the epoch this delta brings the receiver up to, pass it to the next make_delta */
+    epoch_type epoch{ 0 };
+    /** @brief elements inserted since the base epoch */
+    std::vector<std::pair<size_type, value_type>> inserted;
+    /** @brief elements replaced or modified since the base epoch */
+    std::vector<std::pair<size_type, value_type>> modified;
+    /** @brief indice erased since the base epoch */
+    std::vector<size_type> erased;
+
+    /** @return true if there is nothing to apply */
+    [[nodiscard]] bool empty() const noexcept {
+        return inserted.empty() && modified.empty() && erased.empty();
+    }
+};
+
+/** @brief A non-owning view over contiguous elements */
+template<typename Type>
+struct sparse_set_span {
+    Type*       first{ nullptr };
+    uint32_t    count{ 0 };
+
+    [[nodiscard]] constexpr Type* begin() const noexcept { return first; }
+    [[nodiscard]] constexpr Type* end() const noexcept { return first + count; }
+    [[nodiscard]] constexpr Type* data() const noexcept { return first; }
+    [[nodiscard]] constexpr uint32_t size() const noexcept { return count; }
+    [[nodiscard]] constexpr bool empty() const noexcept { return count == 0; }
+    [[nodiscard]] constexpr Type& operator[](uint32_t a_Index) const noexcept { return first[a_Index]; }
+};
+
+namespace sparse_set_detail {
+template<typename Type, typename Policy>
+constexpr sparse_set_storage resolve_storage() noexcept {
+    if constexpr (Policy::storage != sparse_set_storage::automatic) return Policy::storage;
+    else if constexpr (std::is_empty_v<Type> && std::is_trivially_destructible_v<Type>) return sparse_set_storage::tag;
+    else if constexpr (sizeof(Type) > Policy::indirect_threshold) return sparse_set_storage::indirect;
+    else return sparse_set_storage::direct;
+}
+
+/** @brief Names the storage class lazily, so only the selected one is instantiated */
+template<sparse_set_storage Storage, typename Type, uint32_t Size, typename Policy>
+struct select_storage { using type = direct_storage<Type, Size>; };
+template<typename Type, uint32_t Size, typename Policy>
+struct select_storage<sparse_set_storage::indirect, Type, Size, Policy> { using type = indirect_storage<Type, Size>; };
+template<typename Type, uint32_t Size, typename Policy>
+struct select_storage<sparse_set_storage::paged, Type, Size, Policy> { using type = paged_storage<Type, Size, Policy::page_size>; };
+template<typename Type, uint32_t Size, typename Policy>
+struct select_storage<sparse_set_storage::soa, Type, Size, Policy> { using type = field_storage<Type, Size, Size>; };
+template<typename Type, uint32_t Size, typename Policy>
+struct select_storage<sparse_set_storage::aosoa, Type, Size, Policy> { using type = field_storage<Type, Size, Policy::block_size>; };
+template<typename Type, uint32_t Size, typename Policy>
+struct select_storage<sparse_set_storage::tag, Type, Size, Policy> { using type = tag_storage<Type>; };
+}
+
+/**
+* @brief sizeof(sparse_set) is at least sizeof(Type) * Size with direct storage.
+* Large sets should therefore be allocated on the heap.
+* With indirect storage (Policy::storage) elements are allocated by slabs as the
+* set grows and erasing only moves a 4 bytes handle.
+* Empty elements, and sparse_set<void, Size>, only cost their sparse and dense indice.
+* With paged storage elements are allocated by pages as the set grows and
+* growing never moves them.
+* With soa and aosoa storage each field of the elements is stored apart,
+* aosoa grouping them by blocks walked with for_each_block.
+* With tombstone erasure (Policy::erase) elements keep their address until
+* compact() is called, with ordered erasure the elements after the hole are
+* shifted down so dense order stays insertion order.
+* With the rank lookup (Policy::lookup) the sparse array is replaced by an
+* occupancy bitset, elements are kept sorted by index and inserting or erasing
+* moves every element after them, which suits small sets.
+* With a partition (Policy::partition) elements can be disabled instead of
+* erased, they are kept after the enabled ones and skipped by iteration.
+* Under C++20 sets using direct or tag storage and the sparse lookup can be
+* filled, queried and iterated during constant evaluation.
 * Every time an element is erased invalidates every object reference to elements
 * in this set.
 * In general it is ill-advised to keep reference to objects inside the set.
 * Users should instead reference the set and access elements through index when
 * they need it.
 */
-template<typename Type, uint32_t Size>
+template<typename Type, uint32_t Size, typename Policy = sparse_set_policy>
 class sparse_set {
 public:
-    using value_type = Type;
+    using value_type = std::conditional_t<std::is_void_v<Type>, sparse_set_tag, Type>;
     using size_type = decltype(Size);
+    using policy_type = Policy;
+    using delta_type = sparse_set_delta<value_type>;
+    using epoch_type = typename delta_type::epoch_type;
+    using observer_type = typename Policy::observer_type;
+    /** @brief The storage in use, automatic resolved */
+    static constexpr sparse_set_storage storage = sparse_set_detail::resolve_storage<value_type, Policy>();
+    static constexpr bool indirect = storage == sparse_set_storage::indirect;
+    static constexpr bool paged = storage == sparse_set_storage::paged;
+    static constexpr bool soa = storage == sparse_set_storage::soa;
+    static constexpr bool aosoa = storage == sparse_set_storage::aosoa;
+    static constexpr bool tagged = storage == sparse_set_storage::tag;
+    using storage_type = typename sparse_set_detail::select_storage<storage, value_type, Size, Policy>::type;
+    /** @brief value_type& except with soa and aosoa storage, where elements are reached through sparse_set_field_reference */
+    using reference = typename storage_type::reference;
+    using const_reference = typename storage_type::const_reference;
+    static constexpr bool tombstones = Policy::erase == sparse_set_erase::tombstone;
+    static constexpr bool ranked = Policy::lookup == sparse_set_lookup::rank;
+    static_assert(!(ranked && tombstones), "the rank lookup keeps elements sorted and cannot leave tombstones");
+    static_assert(Policy::check != sparse_set_check::mask || (Size & (Size - 1)) == 0, "the mask check requires a power of two Size");
+    /** @brief true if erasing keeps the dense order of the remaining elements */
+    static constexpr bool stable = ranked || Policy::erase == sparse_set_erase::ordered;
+    static constexpr bool partitioned = Policy::partition;
+    static_assert(!(partitioned && (tombstones || stable)), "the partition moves elements across its pivot, which tombstones and stable erase forbid");
 
     constexpr sparse_set() noexcept;
-    inline ~sparse_set() noexcept(std::is_nothrow_invocable_v<decltype(&sparse_set::clear), sparse_set>);
+    SPARSE_SET_CONSTEXPR20 ~sparse_set() noexcept(std::is_nothrow_invocable_v<decltype(&sparse_set::clear), sparse_set>);
 
     /** @return The maximum number of elements that can be inserted in the set*/
     [[nodiscard]] constexpr size_type max_size() const noexcept;
@@ -40,145 +912,1277 @@ public:
     [[nodiscard]] constexpr bool full() const noexcept;
     /** @brief empties the set */
     constexpr void clear()
-        noexcept(std::is_nothrow_invocable_v<decltype(&sparse_set::erase), sparse_set, size_type>);
+        noexcept(std::is_nothrow_destructible_v<value_type>);
 
     /** @return a ref to the element contained at this index */
-    [[nodiscard]] constexpr value_type& at(size_type a_Index);
+    [[nodiscard]] constexpr reference at(size_type a_Index);
     /** @return a ref to the element contained at this index */
-    [[nodiscard]] constexpr const value_type& at(size_type a_Index) const;
+    [[nodiscard]] constexpr const_reference at(size_type a_Index) const;
+
+    /** @return *UNCHECKED* a ref to the element contained at this index */
+    [[nodiscard]] constexpr reference operator[](size_type a_Index) noexcept;
+    /** @return *UNCHECKED* a ref to the element contained at this index */
+    [[nodiscard]] constexpr const_reference operator[](size_type a_Index) const noexcept;
+
+    /**
+    * @brief Inserts a new element at the specified index,
+    * replaces the current element if it already exists
+    * @return a ref to the newly created element
+    */
+    template<typename ...Args>
+    constexpr reference insert(size_type a_Index, Args&&... a_Args);
+    /** @brief Removes the element at the specified index */
+    constexpr void erase(size_type a_Index)
+        noexcept(std::is_nothrow_destructible_v<value_type> && Policy::check != sparse_set_check::exception);
+    /** @return true if a value is attached to this index */
+    constexpr bool contains(size_type a_Index) const;
+    /** @return *UNCHECKED* true if a value is attached to this index */
+    [[nodiscard]] constexpr bool contains_unchecked(size_type a_Index) const noexcept;
+    /**
+    * @return a pointer to the element contained at this index, nullptr if absent.
+    * A single sparse read, unlike contains followed by operator[]. Unavailable with soa and aosoa storage.
+    */
+    [[nodiscard]] constexpr value_type* find(size_type a_Index);
+    /** @copydoc find */
+    [[nodiscard]] constexpr const value_type* find(size_type a_Index) const;
+    /** @return the dense position of the element at this index, max_size() if absent */
+    [[nodiscard]] constexpr size_type find_dense(size_type a_Index) const;
+    /**
+    * @brief Inserts a new element at the specified index constructed from a_Args
+    * unless one already exists, in which case a_Args are left untouched
+    * @return a ref to the element at this index
+    */
+    template<typename ...Args>
+    constexpr reference get_or_insert(size_type a_Index, Args&&... a_Args);
+    /**
+    * @brief Inserts a_Value at the specified index, or assigns it to the existing
+    * element so the buffers it owns are reused instead of freed and reallocated
+    * @return a ref to the element at this index
+    */
+    template<typename Value>
+    constexpr reference insert_or_assign(size_type a_Index, Value&& a_Value);
+    /**
+    * @brief Constructs a new element at the specified index from a_Args, or move assigns
+    * a value constructed from them to the existing element, see insert_or_assign
+    * @return a ref to the element at this index
+    */
+    template<typename ...Args>
+    constexpr reference emplace_or_replace(size_type a_Index, Args&&... a_Args);
+    /**
+    * @return the indice contained in the set, in dense order, disabled ones last.
+    * Unavailable with tombstones as dead slots break the range, use for_each instead.
+    */
+    [[nodiscard]] constexpr sparse_set_span<const size_type> keys() const noexcept;
+    /** @return the indice of the enabled elements, in dense order. Requires Policy::partition */
+    [[nodiscard]] constexpr sparse_set_span<const size_type> enabled_keys() const noexcept;
+    /** @return the number of enabled elements, size() without Policy::partition */
+    [[nodiscard]] constexpr size_type enabled_size() const noexcept;
+    /** @return true if an enabled element is attached to this index */
+    [[nodiscard]] constexpr bool enabled(size_type a_Index) const;
+    /**
+    * @brief Moves the element at this index after the pivot so iteration skips it,
+    * without destroying it. O(1), absent or disabled indice are ignored. Requires Policy::partition
+    */
+    constexpr void disable(size_type a_Index);
+    /** @brief Moves the element at this index back before the pivot, see disable */
+    constexpr void enable(size_type a_Index);
+    /**
+    * @brief Calls a_Func(index, element) for each disabled element in dense order,
+    * with for_each this visits every element. Visits nothing without Policy::partition
+    */
+    template<typename Func>
+    constexpr void for_each_disabled(Func&& a_Func) const;
+    /**
+    * @brief Calls a_Func(index, element) for each element in dense order, skipping tombstones
+    * and disabled elements. With the rank lookup dense order is ascending index order.
+    * Unless tombstones are used a_Func must not erase or clear, which would move unvisited elements,
+    * debug builds assert on it. See for_each_erasable and sparse_set_deferred_erase.
+    */
+    template<typename Func>
+    constexpr void for_each(Func&& a_Func);
+    /** @copydoc for_each */
+    template<typename Func>
+    constexpr void for_each(Func&& a_Func) const;
+    /**
+    * @brief Calls a_Func(index, element) for each element in reverse dense order.
+    * a_Func may erase the current element and the ones already visited:
+    * only visited elements are moved to fill the holes.
+    */
+    template<typename Func>
+    constexpr void for_each_erasable(Func&& a_Func);
+    /**
+    * @brief Calls a_Func(index, element) for each element in ascending index order.
+    * Requires Policy::ordered_iteration or the rank lookup.
+    * Like for_each, a_Func must not erase or clear unless tombstones are used.
+    */
+    template<typename Func>
+    constexpr void for_each_ordered(Func&& a_Func);
+    /** @copydoc for_each_ordered */
+    template<typename Func>
+    constexpr void for_each_ordered(Func&& a_Func) const;
+    /** @brief Calls a_Func(index, element) for each element with an index in [a_First, a_Last), in ascending index order */
+    template<typename Func>
+    constexpr void for_each_ordered(size_type a_First, size_type a_Last, Func&& a_Func);
+    /** @copydoc for_each_ordered(size_type, size_type, Func&&) */
+    template<typename Func>
+    constexpr void for_each_ordered(size_type a_First, size_type a_Last, Func&& a_Func) const;
+    /**
+    * @brief Calls a_Func(indice, elements, count) for each run of elements
+    * contiguous in memory, a page with paged storage or all of them with direct storage.
+    * Unavailable with indirect, soa, aosoa or tag storage and with tombstones.
+    */
+    template<typename Func>
+    constexpr void for_each_page(Func&& a_Func);
+    /**
+    * @brief Calls a_Func(indice, fields, count) for each block of elements,
+    * fields being a std::tuple holding a pointer to count contiguous values of each field.
+    * With aosoa storage a block is one SIMD-width tile, with soa storage it is the whole set.
+    * Only available with soa and aosoa storage, without tombstones.
+    */
+    template<typename Func>
+    constexpr void for_each_block(Func&& a_Func);
+    /**
+    * @return the column holding the field I of every element, in dense order.
+    * Only available with soa storage, without tombstones.
+    */
+    template<size_t I>
+    [[nodiscard]] constexpr auto column() noexcept;
+    /**
+    * @brief Moves the elements over the tombstones, keeping their relative order,
+    * so the dense array is packed again. Invalidates references to elements.
+    */
+    constexpr void compact() noexcept;
 
-    /** @return *UNCHECKED* a ref to the element contained at this index */
-    [[nodiscard]] constexpr value_type& operator[](size_type a_Index) noexcept;
-    /** @return *UNCHECKED* a ref to the element contained at this index */
-    [[nodiscard]] constexpr const value_type& operator[](size_type a_Index) const noexcept;
+    /**
+    * @brief Tests many indice at once, using AVX2/AVX-512 gathers when compiled for them.
+    * Out of bound indice are reported as absent.
+    * @param a_Out bitmask receiving bit i % 64 of word i / 64 for a_Indice[i], (a_Count + 63) / 64 words are written
+    * @return the number of indice contained in the set
+    */
+    size_type contains_many(const size_type* a_Indice, size_type a_Count, uint64_t* a_Out) const noexcept;
+    /**
+    * @brief Looks up the dense position of many indice at once, see contains_many.
+    * @param a_Out receives the position of each index in the dense storage, or max_size() if absent
+    */
+    void find_many(const size_type* a_Indice, size_type a_Count, size_type* a_Out) const noexcept;
+    /**
+    * @brief Looks up many elements at once, pipelining the sparse and dense
+    * cache misses Policy::prefetch_distance indice ahead
+    * @param a_Out receives a pointer to each element, or nullptr if absent or out of bound
+    */
+    void get_many(const size_type* a_Indice, size_type a_Count, value_type** a_Out) noexcept;
+    /** @copydoc get_many */
+    void get_many(const size_type* a_Indice, size_type a_Count, const value_type** a_Out) const noexcept;
+    /** @brief Hints the CPU to fetch the sparse slot of this index */
+    void prefetch(size_type a_Index) const noexcept;
+    /** @brief Hints the CPU to fetch the element at this index, best issued once its sparse slot was prefetched */
+    void prefetch_value(size_type a_Index) const noexcept;
 
     /**
-    * @brief Inserts a new element at the specified index,
-    * replaces the current element if it already exists
-    * @return a ref to the newly created element
+    * @brief Inserts a copy of the same element at each of the specified indice,
+    * replacing existing ones. Newly inserted indice are notified through on_insert_many by batches of 64.
     */
     template<typename ...Args>
-    constexpr value_type& insert(size_type a_Index, Args&&... a_Args)
-        noexcept(std::is_nothrow_constructible_v<value_type, Args...> && std::is_nothrow_destructible_v<value_type>);
-    /** @brief Removes the element at the specified index */
-    constexpr void erase(size_type a_Index)
-        noexcept(std::is_nothrow_destructible_v<value_type>);
-    /** @return true if a value is attached to this index */
-    constexpr bool contains(size_type a_Index) const;
+    constexpr void insert_many(const size_type* a_Indice, size_type a_Count, const Args&... a_Args);
+    /**
+    * @brief Removes the elements at the specified indice, notified through on_erase_many by batches
+    * of 64 before they are destroyed. Absent and repeated indice are skipped, nothing is erased
+    * if an index is out of bound. When erasing is stable the remaining elements are shifted in a single pass.
+    */
+    constexpr void erase_many(const size_type* a_Indice, size_type a_Count)
+        noexcept(std::is_nothrow_destructible_v<value_type> && Policy::check != sparse_set_check::exception);
+
+    /** @return the observer notified by this set, only available when Policy::observer_type isn't void */
+    [[nodiscard]] constexpr auto& observer() noexcept;
+
+    /**
+    * @brief Mutable access hook, flags the element as modified when tracking changes
+    * @return a ref to the element contained at this index
+    */
+    [[nodiscard]] constexpr reference modify(size_type a_Index);
+    /** @return the epoch new changes are stamped with */
+    [[nodiscard]] constexpr epoch_type epoch() const noexcept;
+    /**
+    * @brief Closes the current epoch, further changes will be stamped with a newer one
+    * @return the closed epoch, changes made after this call are newer than it
+    */
+    constexpr epoch_type checkpoint() noexcept;
+    /**
+    * @brief Closes the current epoch and collects every change newer than a_Since,
+    * use 0 to get the whole content of the set
+    * @return the delta, its epoch is to be used as a_Since for the next call
+    */
+    [[nodiscard]] delta_type make_delta(epoch_type a_Since);
+    /** @brief Applies the changes recorded by another set's make_delta */
+    void apply_delta(const delta_type& a_Delta);
 
 private:
-#pragma warning(push)
-#pragma warning(disable : 26495) //variables are left uninitialized on purpose
-    struct storage {
-        size_type                       sparseIndex;
-        alignas(value_type) std::byte   data[sizeof(value_type)];
-        operator value_type& () { return *(value_type*)data; }
+    struct no_tracking {};
+    struct tracking {
+        static constexpr size_type block_count = (Size + 63) / 64;
+        epoch_type                                current{ 1 };
+        std::array<epoch_type, Size>              changed{}; //last epoch the index was inserted, replaced, modified or erased
+        std::array<epoch_type, Size>              inserted{}; //last epoch the index was inserted
+        std::array<epoch_type, block_count>       blockChanged{}; //newest change among 64 indice, allows skipping untouched blocks
     };
-#pragma warning(pop)
+    using tracking_type = std::conditional_t<Policy::track_changes, tracking, no_tracking>;
+    struct no_observer {};
+    static constexpr bool observed = !std::is_void_v<observer_type>;
+    using observer_storage = std::conditional_t<observed, observer_type, no_observer>;
+    constexpr void _stamp(size_type a_Index, bool a_Inserted) noexcept;
+    template<typename Pointer>
+    void _get_many(const size_type* a_Indice, size_type a_Count, Pointer* a_Out) const noexcept;
+    template<typename ...Args>
+    constexpr reference _replace(size_type a_Index, Args&&... a_Args);
+    template<typename ...Args>
+    constexpr reference _insert_new(size_type a_Index, Args&&... a_Args);
+    constexpr void _erase(size_type a_Index);
+    /** @return a_Index once checked according to Policy::check */
+    constexpr size_type _checked(size_type a_Index, const char* a_What) const;
+    /** @return the sparse array gathered by the SIMD lookups, nullptr with the rank lookup which has none */
+    const size_type* _gather_base() const noexcept;
+    template<typename Func>
+    constexpr void _for_each_pos(Func&& a_Func) const;
+    template<typename Func>
+    constexpr void _for_each_enabled_pos(Func&& a_Func) const;
+    constexpr void _swap(size_type a_Left, size_type a_Right) noexcept;
+    constexpr void _shift_down(size_type a_First) noexcept;
+    constexpr void _assert_not_iterated() const noexcept;
+    template<typename Func>
+    constexpr void _for_each_ordered_pos(size_type a_First, size_type a_Last, Func&& a_Func) const;
+
+    struct no_tombstones {};
+    struct tombstone_list {
+        static constexpr size_type word_count = (Size + 63) / 64;
+        size_type end{ 0 }; //dense slots in use, dead ones included
+        size_type free{ Size }; //last dead slot, each dead slot's key holds the previous one
+        std::array<uint64_t, word_count> dead{};
+    };
+    using tombstones_type = std::conditional_t<tombstones, tombstone_list, no_tombstones>;
+
+    using index_type = std::conditional_t<ranked, sparse_set_detail::rank_index<Size>, sparse_set_detail::sparse_index<Size>>;
+    static constexpr bool occupied = Policy::ordered_iteration && !ranked;
+    struct no_occupancy {};
+    using occupancy_type = std::conditional_t<occupied, sparse_set_detail::occupancy<Size>, no_occupancy>;
+    struct no_pivot {};
+    struct pivot {
+        size_type enabled{ 0 }; //dense slots before it hold enabled elements
+    };
+    using pivot_type = std::conditional_t<partitioned, pivot, no_pivot>;
+
     size_type _size{ 0 };
-    std::array<size_type, Size> _sparse;
-    std::array<storage, Size>   _dense;
+    index_type _index; //the dense position of each index
+    std::array<size_type, Size> _keys; //the index of each dense element
+    SPARSE_SET_NO_UNIQUE_ADDRESS storage_type _dense;
+    SPARSE_SET_NO_UNIQUE_ADDRESS tracking_type _tracking;
+    SPARSE_SET_NO_UNIQUE_ADDRESS observer_storage _observer;
+    SPARSE_SET_NO_UNIQUE_ADDRESS tombstones_type _tombstones;
+    SPARSE_SET_NO_UNIQUE_ADDRESS occupancy_type _occupancy;
+    SPARSE_SET_NO_UNIQUE_ADDRESS pivot_type _pivot;
 };
 
-template<typename Type, uint32_t Size>
-constexpr sparse_set<Type, Size>::sparse_set() noexcept {
-    _sparse.fill(max_size());
+template<typename Type, uint32_t Size, typename Policy>
+constexpr sparse_set<Type, Size, Policy>::sparse_set() noexcept {
+    //constant expressions can't hold indeterminate values, at runtime the keys are left uninitialized
+    if (sparse_set_detail::is_constant_evaluated()) _keys.fill(0);
 }
 
-template<typename Type, uint32_t Size>
-inline sparse_set<Type, Size>::~sparse_set()
+template<typename Type, uint32_t Size, typename Policy>
+SPARSE_SET_CONSTEXPR20 sparse_set<Type, Size, Policy>::~sparse_set()
      noexcept(std::is_nothrow_invocable_v<decltype(&sparse_set::clear), sparse_set>)
 {
     clear();
 }
 
-template<typename Type, uint32_t Size>
-constexpr auto sparse_set<Type, Size>::max_size() const noexcept -> size_type {
+template<typename Type, uint32_t Size, typename Policy>
+constexpr auto sparse_set<Type, Size, Policy>::max_size() const noexcept -> size_type {
     return Size;
 }
 
-template<typename Type, uint32_t Size>
-constexpr auto sparse_set<Type, Size>::size() const noexcept -> size_type {
+template<typename Type, uint32_t Size, typename Policy>
+constexpr auto sparse_set<Type, Size, Policy>::size() const noexcept -> size_type {
     return _size;
 }
 
-template<typename Type, uint32_t Size>
-constexpr bool sparse_set<Type, Size>::empty() const noexcept {
+template<typename Type, uint32_t Size, typename Policy>
+constexpr bool sparse_set<Type, Size, Policy>::empty() const noexcept {
     return _size == 0;
 }
 
-template<typename Type, uint32_t Size>
-constexpr bool sparse_set<Type, Size>::full() const noexcept {
+template<typename Type, uint32_t Size, typename Policy>
+constexpr bool sparse_set<Type, Size, Policy>::full() const noexcept {
     return _size == max_size();
 }
 
-template<typename Type, uint32_t Size>
-constexpr void sparse_set<Type, Size>::clear()
-    noexcept(std::is_nothrow_invocable_v<decltype(&sparse_set::erase), sparse_set, size_type>)
+template<typename Type, uint32_t Size, typename Policy>
+constexpr void sparse_set<Type, Size, Policy>::clear()
+    noexcept(std::is_nothrow_destructible_v<value_type>)
 {
-    for (size_type index = 0; !empty(); ++index) {
-        erase(index);
+    _assert_not_iterated();
+    if constexpr (observed && tombstones) {
+        size_type batch[64], batchSize = 0;
+        _for_each_pos([&](size_type a_Pos) {
+            batch[batchSize++] = _keys[a_Pos];
+            if (batchSize == 64) { _observer.on_erase_many(*this, batch, batchSize); batchSize = 0; }
+        });
+        if (batchSize > 0) _observer.on_erase_many(*this, batch, batchSize);
     }
+    else if constexpr (observed) _observer.on_erase_many(*this, _keys.data(), _size);
+    _for_each_pos([this](size_type a_Pos) {
+        _stamp(_keys[a_Pos], false);
+        _index.detach(_keys[a_Pos]);
+        _dense.destroy(a_Pos);
+    });
+    _size = 0;
+    if constexpr (partitioned) _pivot = {};
+    if constexpr (tombstones) _tombstones = {};
+    if constexpr (occupied) _occupancy = {};
 }
 
-template<typename Type, uint32_t Size>
-constexpr auto sparse_set<Type, Size>::at(size_type a_Index) -> value_type& {
+template<typename Type, uint32_t Size, typename Policy>
+constexpr auto sparse_set<Type, Size, Policy>::at(size_type a_Index) -> reference {
     //if a_Index out of bound or element empty, we should crash
-    return _dense.at(_sparse.at(a_Index));
+    const auto pos = _index.find(_checked(a_Index, "sparse_set::at: index out of bound"));
+    if (pos == max_size()) throw std::out_of_range("sparse_set::at: no element at this index");
+    return _dense.get(pos);
 }
 
-template<typename Type, uint32_t Size>
-constexpr auto sparse_set<Type, Size>::at(size_type a_Index) const -> const value_type& {
-    return _dense.at(_sparse.at(a_Index));
+template<typename Type, uint32_t Size, typename Policy>
+constexpr auto sparse_set<Type, Size, Policy>::at(size_type a_Index) const -> const_reference {
+    const auto pos = _index.find(_checked(a_Index, "sparse_set::at: index out of bound"));
+    if (pos == max_size()) throw std::out_of_range("sparse_set::at: no element at this index");
+    return _dense.get(pos);
 }
 
-template<typename Type, uint32_t Size>
-constexpr auto sparse_set<Type, Size>::operator[](size_type a_Index) noexcept -> value_type& {
-    return _dense[_sparse[a_Index]];
+template<typename Type, uint32_t Size, typename Policy>
+constexpr auto sparse_set<Type, Size, Policy>::operator[](size_type a_Index) noexcept -> reference {
+    return _dense.get(_index.find(a_Index));
 }
 
-template<typename Type, uint32_t Size>
-constexpr auto sparse_set<Type, Size>::operator[](size_type a_Index) const noexcept -> const value_type& {
-    return _dense[_sparse[a_Index]];
+template<typename Type, uint32_t Size, typename Policy>
+constexpr auto sparse_set<Type, Size, Policy>::operator[](size_type a_Index) const noexcept -> const_reference {
+    return _dense.get(_index.find(a_Index));
 }
 
-template<typename Type, uint32_t Size>
+template<typename Type, uint32_t Size, typename Policy>
 template<typename ...Args>
-constexpr auto sparse_set<Type, Size>::insert(size_type a_Index, Args && ...a_Args)
-    noexcept(std::is_nothrow_constructible_v<value_type, Args...> && std::is_nothrow_destructible_v<value_type>) -> value_type&
+constexpr auto sparse_set<Type, Size, Policy>::insert(size_type a_Index, Args && ...a_Args) -> reference
 {
-    if (contains(a_Index)) //just replace the element
+    a_Index = _checked(a_Index, "sparse_set::insert: index out of bound");
+    if (_index.contains(a_Index)) //just replace the element
     {
-        auto& dense = _dense[_sparse[a_Index]];
-        std::destroy_at((value_type*)dense.data);
-        return *new(dense.data) value_type(std::forward<Args>(a_Args)...);
-    }
-    //push new element back
-    _sparse[a_Index] = _size;
-    auto& dense = _dense.at(_size); //if full it should crash here
-    dense.sparseIndex = a_Index;
-    _size++;
-    return *new(dense.data) value_type(std::forward<Args>(a_Args)...);
+        decltype(auto) value = _replace(a_Index, std::forward<Args>(a_Args)...);
+        if constexpr (observed) _observer.on_replace(*this, a_Index);
+        return value;
+    }
+    decltype(auto) value = _insert_new(a_Index, std::forward<Args>(a_Args)...);
+    if constexpr (observed) _observer.on_insert(*this, a_Index);
+    return value;
 }
 
-template<typename Type, uint32_t Size>
-constexpr void sparse_set<Type, Size>::erase(size_type a_Index)
-    noexcept(std::is_nothrow_destructible_v<value_type>)
+template<typename Type, uint32_t Size, typename Policy>
+template<typename Value>
+constexpr auto sparse_set<Type, Size, Policy>::insert_or_assign(size_type a_Index, Value&& a_Value) -> reference {
+    a_Index = _checked(a_Index, "sparse_set::insert_or_assign: index out of bound");
+    const auto pos = _index.find(a_Index);
+    if (pos == max_size()) {
+        decltype(auto) value = _insert_new(a_Index, std::forward<Value>(a_Value));
+        if constexpr (observed) _observer.on_insert(*this, a_Index);
+        return value;
+    }
+    _stamp(a_Index, false);
+    decltype(auto) value = _dense.get(pos);
+    value = std::forward<Value>(a_Value);
+    if constexpr (observed) _observer.on_replace(*this, a_Index);
+    return value;
+}
+
+template<typename Type, uint32_t Size, typename Policy>
+template<typename ...Args>
+constexpr auto sparse_set<Type, Size, Policy>::emplace_or_replace(size_type a_Index, Args&&... a_Args) -> reference {
+    a_Index = _checked(a_Index, "sparse_set::emplace_or_replace: index out of bound");
+    if (_index.contains(a_Index)) return insert_or_assign(a_Index, value_type(std::forward<Args>(a_Args)...));
+    decltype(auto) value = _insert_new(a_Index, std::forward<Args>(a_Args)...);
+    if constexpr (observed) _observer.on_insert(*this, a_Index);
+    return value;
+}
+
+template<typename Type, uint32_t Size, typename Policy>
+constexpr void sparse_set<Type, Size, Policy>::erase(size_type a_Index)
+    noexcept(std::is_nothrow_destructible_v<value_type> && Policy::check != sparse_set_check::exception)
+{
+    a_Index = _checked(a_Index, "sparse_set::erase: index out of bound");
+    if (empty() || !_index.contains(a_Index)) return;
+    _assert_not_iterated();
+    if constexpr (observed) _observer.on_erase(*this, a_Index);
+    _erase(a_Index);
+}
+
+template<typename Type, uint32_t Size, typename Policy>
+constexpr bool sparse_set<Type, Size, Policy>::contains(size_type a_Index) const {
+    return _index.contains(_checked(a_Index, "sparse_set::contains: index out of bound"));
+}
+
+template<typename Type, uint32_t Size, typename Policy>
+constexpr bool sparse_set<Type, Size, Policy>::contains_unchecked(size_type a_Index) const noexcept {
+    return _index.contains(a_Index);
+}
+
+template<typename Type, uint32_t Size, typename Policy>
+constexpr auto sparse_set<Type, Size, Policy>::find(size_type a_Index) -> value_type* {
+    static_assert(!soa && !aosoa, "find requires elements stored whole, use find_dense with soa and aosoa storage");
+    const auto pos = find_dense(a_Index);
+    return pos != max_size() ? &_dense.get(pos) : nullptr;
+}
+
+template<typename Type, uint32_t Size, typename Policy>
+constexpr auto sparse_set<Type, Size, Policy>::find(size_type a_Index) const -> const value_type* {
+    static_assert(!soa && !aosoa, "find requires elements stored whole, use find_dense with soa and aosoa storage");
+    const auto pos = find_dense(a_Index);
+    return pos != max_size() ? &_dense.get(pos) : nullptr;
+}
+
+template<typename Type, uint32_t Size, typename Policy>
+constexpr auto sparse_set<Type, Size, Policy>::find_dense(size_type a_Index) const -> size_type {
+    return _index.find(_checked(a_Index, "sparse_set::find: index out of bound"));
+}
+
+template<typename Type, uint32_t Size, typename Policy>
+template<typename ...Args>
+constexpr auto sparse_set<Type, Size, Policy>::get_or_insert(size_type a_Index, Args&&... a_Args) -> reference {
+    a_Index = _checked(a_Index, "sparse_set::get_or_insert: index out of bound");
+    const auto pos = _index.find(a_Index);
+    if (pos != max_size()) return _dense.get(pos);
+    decltype(auto) value = _insert_new(a_Index, std::forward<Args>(a_Args)...);
+    if constexpr (observed) _observer.on_insert(*this, a_Index);
+    return value;
+}
+
+template<typename Type, uint32_t Size, typename Policy>
+constexpr auto sparse_set<Type, Size, Policy>::keys() const noexcept -> sparse_set_span<const size_type> {
+    static_assert(!tombstones, "keys() is unavailable with tombstones, use for_each");
+    return { _keys.data(), _size };
+}
+
+template<typename Type, uint32_t Size, typename Policy>
+constexpr auto sparse_set<Type, Size, Policy>::enabled_keys() const noexcept -> sparse_set_span<const size_type> {
+    static_assert(partitioned, "enabled_keys() requires Policy::partition");
+    return { _keys.data(), _pivot.enabled };
+}
+
+template<typename Type, uint32_t Size, typename Policy>
+constexpr auto sparse_set<Type, Size, Policy>::enabled_size() const noexcept -> size_type {
+    if constexpr (partitioned) return _pivot.enabled;
+    else return _size;
+}
+
+template<typename Type, uint32_t Size, typename Policy>
+constexpr bool sparse_set<Type, Size, Policy>::enabled(size_type a_Index) const {
+    const auto pos = find_dense(a_Index);
+    if constexpr (partitioned) return pos < _pivot.enabled;
+    else return pos != max_size();
+}
+
+template<typename Type, uint32_t Size, typename Policy>
+constexpr void sparse_set<Type, Size, Policy>::disable(size_type a_Index) {
+    static_assert(partitioned, "disable() requires Policy::partition");
+    const auto pos = find_dense(a_Index);
+    if (pos >= _pivot.enabled) return; //absent or already disabled
+    _swap(pos, --_pivot.enabled);
+}
+
+template<typename Type, uint32_t Size, typename Policy>
+constexpr void sparse_set<Type, Size, Policy>::enable(size_type a_Index) {
+    static_assert(partitioned, "enable() requires Policy::partition");
+    const auto pos = find_dense(a_Index);
+    if (pos == max_size() || pos < _pivot.enabled) return; //absent or already enabled
+    _swap(pos, _pivot.enabled++);
+}
+
+template<typename Type, uint32_t Size, typename Policy>
+template<typename Func>
+constexpr void sparse_set<Type, Size, Policy>::for_each_disabled(Func&& a_Func) const {
+    if constexpr (partitioned)
+        for (size_type pos = _pivot.enabled; pos < _size; ++pos) a_Func(_keys[pos], _dense.get(pos));
+}
+
+template<typename Type, uint32_t Size, typename Policy>
+template<typename Func>
+constexpr void sparse_set<Type, Size, Policy>::for_each(Func&& a_Func) {
+#ifndef NDEBUG
+    const sparse_set_detail::iteration_guard guard(this);
+#endif
+    _for_each_enabled_pos([&](size_type a_Pos) { a_Func(_keys[a_Pos], _dense.get(a_Pos)); });
+}
+
+template<typename Type, uint32_t Size, typename Policy>
+template<typename Func>
+constexpr void sparse_set<Type, Size, Policy>::for_each(Func&& a_Func) const {
+    _for_each_enabled_pos([&](size_type a_Pos) { a_Func(_keys[a_Pos], _dense.get(a_Pos)); });
+}
+
+template<typename Type, uint32_t Size, typename Policy>
+template<typename Func>
+constexpr void sparse_set<Type, Size, Policy>::for_each_erasable(Func&& a_Func) {
+    //the unvisited elements stay in [0, pos) whatever a_Func erases behind it
+    size_type pos = enabled_size();
+    if constexpr (tombstones) pos = _tombstones.end;
+    while (pos-- > 0) {
+        if constexpr (tombstones) if (_tombstones.dead[pos / 64] & (uint64_t(1) << (pos % 64))) continue;
+        a_Func(_keys[pos], _dense.get(pos));
+    }
+}
+
+template<typename Type, uint32_t Size, typename Policy>
+template<typename Func>
+constexpr void sparse_set<Type, Size, Policy>::for_each_ordered(Func&& a_Func) {
+    for_each_ordered(0, max_size(), std::forward<Func>(a_Func));
+}
+
+template<typename Type, uint32_t Size, typename Policy>
+template<typename Func>
+constexpr void sparse_set<Type, Size, Policy>::for_each_ordered(Func&& a_Func) const {
+    for_each_ordered(0, max_size(), std::forward<Func>(a_Func));
+}
+
+template<typename Type, uint32_t Size, typename Policy>
+template<typename Func>
+constexpr void sparse_set<Type, Size, Policy>::for_each_ordered(size_type a_First, size_type a_Last, Func&& a_Func) {
+#ifndef NDEBUG
+    const sparse_set_detail::iteration_guard guard(this);
+#endif
+    _for_each_ordered_pos(a_First, a_Last, [&](size_type a_Pos) { a_Func(_keys[a_Pos], _dense.get(a_Pos)); });
+}
+
+template<typename Type, uint32_t Size, typename Policy>
+template<typename Func>
+constexpr void sparse_set<Type, Size, Policy>::for_each_ordered(size_type a_First, size_type a_Last, Func&& a_Func) const {
+    _for_each_ordered_pos(a_First, a_Last, [&](size_type a_Pos) { a_Func(_keys[a_Pos], _dense.get(a_Pos)); });
+}
+
+template<typename Type, uint32_t Size, typename Policy>
+template<typename Func>
+constexpr void sparse_set<Type, Size, Policy>::for_each_page(Func&& a_Func) {
+    static_assert(!indirect && !tagged && !soa && !aosoa && !tombstones, "for_each_page requires contiguous elements and no tombstones");
+    constexpr size_type pageSize = storage_type::page_size;
+#ifndef NDEBUG
+    const sparse_set_detail::iteration_guard guard(this);
+#endif
+    const size_type end = enabled_size();
+    for (size_type first = 0; first < end; first += pageSize)
+        a_Func(_keys.data() + first, _dense.data(first), std::min(pageSize, end - first));
+}
+
+template<typename Type, uint32_t Size, typename Policy>
+template<typename Func>
+constexpr void sparse_set<Type, Size, Policy>::for_each_block(Func&& a_Func) {
+    static_assert((soa || aosoa) && !tombstones, "for_each_block requires soa or aosoa storage and no tombstones");
+    constexpr size_type blockSize = storage_type::block_size;
+#ifndef NDEBUG
+    const sparse_set_detail::iteration_guard guard(this);
+#endif
+    const size_type end = enabled_size();
+    for (size_type first = 0; first < end; first += blockSize)
+        a_Func(_keys.data() + first, _dense.block(first), std::min(blockSize, end - first));
+}
+
+template<typename Type, uint32_t Size, typename Policy>
+template<size_t I>
+constexpr auto sparse_set<Type, Size, Policy>::column() noexcept {
+    static_assert(soa && !tombstones, "column() requires soa storage and no tombstones");
+    using field_type = std::remove_reference_t<decltype(_dense.template column<I>()[0])>;
+    return sparse_set_span<field_type>{ _dense.template column<I>(), _size };
+}
+
+template<typename Type, uint32_t Size, typename Policy>
+constexpr void sparse_set<Type, Size, Policy>::compact() noexcept {
+    if constexpr (tombstones) {
+        size_type write = 0;
+        _for_each_pos([&](size_type a_Pos) {
+            if (a_Pos != write) {
+                _dense.relocate(a_Pos, write);
+                _keys[write] = _keys[a_Pos];
+                _index.attach(_keys[write], write);
+            }
+            write++;
+        });
+        _tombstones = {};
+        _tombstones.end = write;
+    }
+}
+
+template<typename Type, uint32_t Size, typename Policy>
+constexpr auto sparse_set<Type, Size, Policy>::modify(size_type a_Index) -> reference {
+    decltype(auto) value = at(a_Index);
+    _stamp(a_Index, false);
+    return value;
+}
+
+template<typename Type, uint32_t Size, typename Policy>
+constexpr auto sparse_set<Type, Size, Policy>::epoch() const noexcept -> epoch_type {
+    if constexpr (Policy::track_changes) return _tracking.current;
+    else return 0;
+}
+
+template<typename Type, uint32_t Size, typename Policy>
+constexpr auto sparse_set<Type, Size, Policy>::checkpoint() noexcept -> epoch_type {
+    if constexpr (Policy::track_changes) return _tracking.current++;
+    else return 0;
+}
+
+template<typename Type, uint32_t Size, typename Policy>
+auto sparse_set<Type, Size, Policy>::make_delta(epoch_type a_Since) -> delta_type {
+    static_assert(Policy::track_changes, "make_delta requires a policy with track_changes enabled");
+    delta_type delta;
+    for (size_type block = 0; block < tracking::block_count; ++block) {
+        if (_tracking.blockChanged[block] <= a_Since) continue;
+        const size_type last = std::min(Size, (block + 1) * 64);
+        for (size_type index = block * 64; index < last; ++index) {
+            if (_tracking.changed[index] <= a_Since) continue;
+            if (!contains(index)) //erased, or inserted then erased which is harmless to send
+                delta.erased.push_back(index);
+            else if (_tracking.inserted[index] > a_Since)
+                delta.inserted.emplace_back(index, operator[](index));
+            else
+                delta.modified.emplace_back(index, operator[](index));
+        }
+    }
+    delta.epoch = checkpoint();
+    return delta;
+}
+
+template<typename Type, uint32_t Size, typename Policy>
+void sparse_set<Type, Size, Policy>::apply_delta(const delta_type& a_Delta) {
+    for (auto& index : a_Delta.erased) erase(index);
+    for (auto& [index, value] : a_Delta.inserted) insert(index, value);
+    for (auto& [index, value] : a_Delta.modified) {
+        if (contains(index)) modify(index) = value;
+        else insert(index, value);
+    }
+}
+
+template<typename Type, uint32_t Size, typename Policy>
+constexpr void sparse_set<Type, Size, Policy>::_stamp(size_type a_Index, bool a_Inserted) noexcept {
+    if constexpr (Policy::track_changes) {
+        _tracking.changed[a_Index] = _tracking.current;
+        _tracking.blockChanged[a_Index / 64] = _tracking.current;
+        if (a_Inserted) _tracking.inserted[a_Index] = _tracking.current;
+    }
+}
+
+template<typename Type, uint32_t Size, typename Policy>
+template<typename ...Args>
+constexpr void sparse_set<Type, Size, Policy>::insert_many(const size_type* a_Indice, size_type a_Count, const Args&... a_Args) {
+    [[maybe_unused]] size_type batch[64], batchSize = 0;
+    for (size_type i = 0; i < a_Count; ++i) {
+        const auto index = _checked(a_Indice[i], "sparse_set::insert_many: index out of bound");
+        if (_index.contains(index)) {
+            _replace(index, a_Args...);
+            if constexpr (observed) _observer.on_replace(*this, index);
+            continue;
+        }
+        _insert_new(index, a_Args...);
+        if constexpr (observed) {
+            batch[batchSize++] = index;
+            if (batchSize == 64) { _observer.on_insert_many(*this, batch, batchSize); batchSize = 0; }
+        }
+    }
+    if constexpr (observed) if (batchSize > 0) _observer.on_insert_many(*this, batch, batchSize);
+}
+
+template<typename Type, uint32_t Size, typename Policy>
+constexpr void sparse_set<Type, Size, Policy>::erase_many(const size_type* a_Indice, size_type a_Count)
+    noexcept(std::is_nothrow_destructible_v<value_type> && Policy::check != sparse_set_check::exception)
 {
-    if (empty() || !contains(a_Index)) return;
+    _assert_not_iterated();
+    //an out of bound index must throw before anything is notified or destroyed
+    if constexpr (Policy::check == sparse_set_check::exception)
+        for (size_type i = 0; i < a_Count; ++i) (void)_checked(a_Indice[i], "sparse_set::erase_many: index out of bound");
+    [[maybe_unused]] size_type batch[64], batchSize = 0;
+    [[maybe_unused]] size_type first = _size;
+    const auto destroy = [&](size_type a_Index) {
+        if constexpr (stable) { //the holes are closed at once after the loop
+            const auto pos = _index.find(a_Index); //a rank with the rank lookup, valid until something is detached
+            _stamp(a_Index, false);
+            if constexpr (occupied) _occupancy.reset(a_Index);
+            _dense.destroy(pos);
+            _keys[pos] = max_size(); //marks the hole for _shift_down
+            first = std::min(first, pos);
+        }
+        else _erase(a_Index);
+    };
+    const auto flush = [&] {
+        if constexpr (observed) _observer.on_erase_many(*this, batch, batchSize);
+        for (size_type i = 0; i < batchSize; ++i) destroy(batch[i]);
+        batchSize = 0;
+    };
+    for (size_type i = 0; i < a_Count; ++i) {
+        const auto index = _checked(a_Indice[i], "sparse_set::erase_many: index out of bound");
+        if (!_index.contains(index)) continue;
+        if constexpr (stable) if (_keys[_index.find(index)] != index) continue; //listed twice, already destroyed
+        if constexpr (observed) {
+            if (std::find(batch, batch + batchSize, index) != batch + batchSize) continue; //listed twice in this batch
+            batch[batchSize++] = index;
+            if (batchSize == 64) flush();
+        }
+        else destroy(index);
+    }
+    if constexpr (observed) if (batchSize > 0) flush();
+    if constexpr (stable) {
+        for (size_type i = 0; i < a_Count; ++i) {
+            const auto index = _checked(a_Indice[i], "sparse_set::erase_many: index out of bound");
+            if (_index.contains(index)) _index.detach(index);
+        }
+        _shift_down(first);
+    }
+}
+
+template<typename Type, uint32_t Size, typename Policy>
+constexpr auto& sparse_set<Type, Size, Policy>::observer() noexcept {
+    static_assert(observed, "observer() requires a policy with an observer_type");
+    return _observer;
+}
+
+template<typename Type, uint32_t Size, typename Policy>
+template<typename ...Args>
+constexpr auto sparse_set<Type, Size, Policy>::_replace(size_type a_Index, Args&& ...a_Args) -> reference {
+    _stamp(a_Index, false);
+    const auto pos = _index.find(a_Index);
+    _dense.destroy(pos);
+    return _dense.construct(pos, std::forward<Args>(a_Args)...);
+}
+
+template<typename Type, uint32_t Size, typename Policy>
+template<typename ...Args>
+constexpr auto sparse_set<Type, Size, Policy>::_insert_new(size_type a_Index, Args&& ...a_Args) -> reference {
+    if (full()) throw std::out_of_range("sparse_set::insert: the set is full");
+    size_type pos = _size;
+    if constexpr (tombstones) pos = _tombstones.free != max_size() ? _tombstones.free : _tombstones.end;
+    //the moves below write the slot at _size before anything is constructed there
+    if constexpr (paged && (ranked || partitioned)) _dense.ensure(_size);
+    if constexpr (partitioned) { //new elements are enabled, the first disabled one moves to the end
+        if (_pivot.enabled != _size) {
+            _dense.relocate(_pivot.enabled, _size);
+            _keys[_size] = _keys[_pivot.enabled];
+            _index.attach(_keys[_size], _size);
+        }
+        pos = _pivot.enabled++;
+    }
+    if constexpr (ranked) { //open a hole at the rank of a_Index, keeping the elements sorted
+        pos = _index.rank(a_Index);
+        for (size_type from = _size; from > pos; --from) _dense.relocate(from - 1, from);
+        std::copy_backward(_keys.begin() + pos, _keys.begin() + _size, _keys.begin() + _size + 1);
+    }
+    //puts the moved elements back if the constructor throws
+    sparse_set_detail::rollback undo([&] {
+        if constexpr (partitioned) {
+            _pivot.enabled = pos;
+            if (pos != _size) {
+                _dense.relocate(_size, pos);
+                _keys[pos] = _keys[_size];
+                _index.attach(_keys[pos], pos);
+            }
+        }
+        if constexpr (ranked) {
+            for (size_type from = pos; from < _size; ++from) _dense.relocate(from + 1, from);
+            std::copy(_keys.begin() + pos + 1, _keys.begin() + _size + 1, _keys.begin() + pos);
+        }
+    });
+    decltype(auto) value = _dense.construct(pos, std::forward<Args>(a_Args)...);
+    undo.dismiss();
+    if constexpr (tombstones) {
+        if (pos == _tombstones.end) _tombstones.end++;
+        else {
+            _tombstones.free = _keys[pos];
+            _tombstones.dead[pos / 64] &= ~(uint64_t(1) << (pos % 64));
+        }
+    }
+    _index.attach(a_Index, pos);
+    if constexpr (occupied) _occupancy.set(a_Index);
+    _keys[pos] = a_Index;
+    _size++;
+    _stamp(a_Index, true);
+    return value;
+}
+
+template<typename Type, uint32_t Size, typename Policy>
+constexpr void sparse_set<Type, Size, Policy>::_erase(size_type a_Index) {
+    _stamp(a_Index, false);
+    if constexpr (occupied) _occupancy.reset(a_Index);
     _size--;
-    auto& currDense = _dense[_sparse[a_Index]];
-    auto& lastDense = _dense[_size];
-    size_type lastIndex = lastDense.sparseIndex;
-    std::destroy_at((value_type*)currDense.data); //call current data's destructor
-    std::memmove(currDense.data, lastDense.data, sizeof(value_type)); //crush current data with last data
-    std::swap(lastDense.sparseIndex, currDense.sparseIndex);
-    std::swap(_sparse[lastIndex], _sparse[a_Index]);
-    _sparse[a_Index] = max_size();
+    const size_type currPos = _index.find(a_Index);
+    if constexpr (tombstones) {
+        _dense.destroy(currPos);
+        _keys[currPos] = _tombstones.free;
+        _tombstones.free = currPos;
+        _tombstones.dead[currPos / 64] |= uint64_t(1) << (currPos % 64);
+        _index.detach(a_Index);
+        return;
+    }
+    if constexpr (stable) { //close the hole, keeping the elements sorted or in insertion order
+        _dense.destroy(currPos);
+        for (size_type pos = currPos; pos < _size; ++pos) {
+            _dense.relocate(pos + 1, pos);
+            _keys[pos] = _keys[pos + 1];
+            if constexpr (!ranked) _index.attach(_keys[pos], pos); //ranks already account for the hole
+        }
+        _index.detach(a_Index);
+        return;
+    }
+    if constexpr (partitioned) if (currPos < _pivot.enabled) {
+        //the last enabled element fills the hole, the last element fills its slot
+        _dense.destroy(currPos);
+        if (currPos != --_pivot.enabled) {
+            _dense.relocate(_pivot.enabled, currPos);
+            _keys[currPos] = _keys[_pivot.enabled];
+            _index.attach(_keys[currPos], currPos);
+        }
+        if (_pivot.enabled != _size) {
+            _dense.relocate(_size, _pivot.enabled);
+            _keys[_pivot.enabled] = _keys[_size];
+            _index.attach(_keys[_pivot.enabled], _pivot.enabled);
+        }
+        _index.detach(a_Index);
+        return;
+    }
+    const size_type lastIndex = _keys[_size];
+    _dense.destroy(currPos); //call current data's destructor
+    if (currPos != _size) _dense.relocate(_size, currPos); //crush current data with last data
+    _keys[currPos] = lastIndex;
+    _index.attach(lastIndex, currPos);
+    _index.detach(a_Index);
 }
 
-template<typename Type, uint32_t Size>
-constexpr bool sparse_set<Type, Size>::contains(size_type a_Index) const {
-    //if a_Index is out of bound we should crash here
-    return _sparse.at(a_Index) != max_size();
+template<typename Type, uint32_t Size, typename Policy>
+auto sparse_set<Type, Size, Policy>::_gather_base() const noexcept -> const size_type* {
+    if constexpr (ranked) return nullptr;
+    else return _index.data();
+}
+
+template<typename Type, uint32_t Size, typename Policy>
+constexpr auto sparse_set<Type, Size, Policy>::_checked(size_type a_Index, [[maybe_unused]] const char* a_What) const -> size_type {
+    if constexpr (Policy::check == sparse_set_check::exception) {
+        if (a_Index >= max_size()) throw std::out_of_range(a_What);
+    }
+    else if constexpr (Policy::check == sparse_set_check::assertion) assert(a_Index < max_size() && a_What);
+    else if constexpr (Policy::check == sparse_set_check::mask) return a_Index & (Size - 1);
+    return a_Index;
+}
+
+template<typename Type, uint32_t Size, typename Policy>
+template<typename Func>
+constexpr void sparse_set<Type, Size, Policy>::_for_each_pos(Func&& a_Func) const {
+    if constexpr (tombstones) {
+        const size_type end = _tombstones.end;
+        for (size_type word = 0; word * 64 < end; ++word) {
+            uint64_t alive = ~_tombstones.dead[word];
+            if (end - word * 64 < 64) alive &= (uint64_t(1) << (end - word * 64)) - 1;
+            for (; alive != 0; alive &= alive - 1)
+                a_Func(word * 64 + size_type(sparse_set_detail::countr_zero(alive)));
+        }
+    }
+    else {
+        for (size_type pos = 0; pos < _size; ++pos) a_Func(pos);
+    }
+}
+
+template<typename Type, uint32_t Size, typename Policy>
+template<typename Func>
+constexpr void sparse_set<Type, Size, Policy>::_for_each_ordered_pos(size_type a_First, size_type a_Last, Func&& a_Func) const {
+    static_assert(occupied || ranked, "for_each_ordered requires Policy::ordered_iteration or the rank lookup");
+    a_Last = std::min(a_Last, max_size());
+    if (a_First >= a_Last) return;
+    if constexpr (ranked) { //elements are sorted, the range is a run of positions
+        const size_type last = a_Last == max_size() ? _size : _index.rank(a_Last);
+        for (size_type pos = _index.rank(a_First); pos < last; ++pos) a_Func(pos);
+    }
+    else _occupancy.for_each(a_First, a_Last, [&](size_type a_Index) {
+        const auto pos = _index.find(a_Index);
+        if constexpr (partitioned) { if (pos < _pivot.enabled) a_Func(pos); }
+        else a_Func(pos);
+    });
+}
+
+template<typename Type, uint32_t Size, typename Policy>
+template<typename Func>
+constexpr void sparse_set<Type, Size, Policy>::_for_each_enabled_pos(Func&& a_Func) const {
+    if constexpr (partitioned) for (size_type pos = 0; pos < _pivot.enabled; ++pos) a_Func(pos);
+    else _for_each_pos(std::forward<Func>(a_Func));
+}
+
+template<typename Type, uint32_t Size, typename Policy>
+constexpr void sparse_set<Type, Size, Policy>::_swap(size_type a_Left, size_type a_Right) noexcept {
+    if (a_Left == a_Right) return;
+    _dense.swap(a_Left, a_Right);
+    std::swap(_keys[a_Left], _keys[a_Right]);
+    _index.attach(_keys[a_Left], a_Left);
+    _index.attach(_keys[a_Right], a_Right);
+}
+
+template<typename Type, uint32_t Size, typename Policy>
+constexpr void sparse_set<Type, Size, Policy>::_assert_not_iterated() const noexcept {
+#ifndef NDEBUG
+    if constexpr (!tombstones) assert((sparse_set_detail::is_constant_evaluated() || !sparse_set_detail::iteration_guard::iterating(this))
+        && "sparse_set: erased while for_each walks the set, use for_each_erasable or sparse_set_deferred_erase");
+#endif
+}
+
+/** @brief Packs the elements from a_First on over the destroyed ones, whose key is max_size() */
+template<typename Type, uint32_t Size, typename Policy>
+constexpr void sparse_set<Type, Size, Policy>::_shift_down(size_type a_First) noexcept {
+    size_type write = a_First;
+    for (size_type read = a_First; read < _size; ++read) {
+        if (_keys[read] == max_size()) continue;
+        if (read != write) {
+            _dense.relocate(read, write);
+            _keys[write] = _keys[read];
+            if constexpr (!ranked) _index.attach(_keys[write], write); //ranks already account for the holes
+        }
+        write++;
+    }
+    _size = write;
+}
+
+template<typename Type, uint32_t Size, typename Policy>
+auto sparse_set<Type, Size, Policy>::contains_many(const size_type* a_Indice, size_type a_Count, uint64_t* a_Out) const noexcept -> size_type {
+    size_type found = 0;
+    size_type i = 0;
+    for (size_type word = 0; i < a_Count; ++word) {
+        uint64_t bits = 0;
+        const size_type end = std::min(a_Count, i + 64);
+#if defined(__AVX512F__)
+        const auto sparse = (const int*)_gather_base();
+        const auto size = _mm512_set1_epi32(int(Size));
+        for (size_type bit = 0; !ranked && i + 16 <= end; i += 16, bit += 16) {
+            const auto keys = _mm512_loadu_si512(a_Indice + i);
+            const auto inBounds = _mm512_cmplt_epu32_mask(keys, size);
+            const auto dense = _mm512_mask_i32gather_epi32(size, inBounds, keys, sparse, 4);
+            bits |= uint64_t(_mm512_cmpneq_epu32_mask(dense, size)) << bit;
+        }
+#elif defined(__AVX2__)
+        const auto sparse = (const int*)_gather_base();
+        const auto size = _mm256_set1_epi32(int(Size));
+        const auto last = _mm256_set1_epi32(int(Size - 1));
+        for (size_type bit = 0; !ranked && i + 8 <= end; i += 8, bit += 8) {
+            const auto keys = _mm256_loadu_si256((const __m256i*)(a_Indice + i));
+            const auto inBounds = _mm256_cmpeq_epi32(_mm256_min_epu32(keys, last), keys);
+            const auto dense = _mm256_mask_i32gather_epi32(size, sparse, keys, inBounds, 4);
+            const auto absent = _mm256_cmpeq_epi32(dense, size);
+            bits |= uint64_t(~_mm256_movemask_ps(_mm256_castsi256_ps(absent)) & 0xFF) << bit;
+        }
+#endif
+        for (; i < end; ++i) {
+            const auto index = a_Indice[i];
+            bits |= uint64_t(index < Size && _index.contains(index)) << (i % 64);
+        }
+        a_Out[word] = bits;
+        found += size_type(sparse_set_detail::popcount(bits));
+    }
+    return found;
+}
+
+template<typename Type, uint32_t Size, typename Policy>
+void sparse_set<Type, Size, Policy>::find_many(const size_type* a_Indice, size_type a_Count, size_type* a_Out) const noexcept {
+    size_type i = 0;
+#if defined(__AVX512F__)
+    const auto sparse = (const int*)_gather_base();
+    const auto size = _mm512_set1_epi32(int(Size));
+    for (; !ranked && i + 16 <= a_Count; i += 16) {
+        const auto keys = _mm512_loadu_si512(a_Indice + i);
+        const auto inBounds = _mm512_cmplt_epu32_mask(keys, size);
+        _mm512_storeu_si512(a_Out + i, _mm512_mask_i32gather_epi32(size, inBounds, keys, sparse, 4));
+    }
+#elif defined(__AVX2__)
+    const auto sparse = (const int*)_gather_base();
+    const auto size = _mm256_set1_epi32(int(Size));
+    const auto last = _mm256_set1_epi32(int(Size - 1));
+    for (; !ranked && i + 8 <= a_Count; i += 8) {
+        const auto keys = _mm256_loadu_si256((const __m256i*)(a_Indice + i));
+        const auto inBounds = _mm256_cmpeq_epi32(_mm256_min_epu32(keys, last), keys);
+        _mm256_storeu_si256((__m256i*)(a_Out + i), _mm256_mask_i32gather_epi32(size, sparse, keys, inBounds, 4));
+    }
+#endif
+    for (; i < a_Count; ++i) {
+        const auto index = a_Indice[i];
+        a_Out[i] = index < Size ? _index.find(index) : max_size();
+    }
+}
+
+template<typename Type, uint32_t Size, typename Policy>
+void sparse_set<Type, Size, Policy>::get_many(const size_type* a_Indice, size_type a_Count, value_type** a_Out) noexcept {
+    _get_many(a_Indice, a_Count, a_Out);
+}
+
+template<typename Type, uint32_t Size, typename Policy>
+void sparse_set<Type, Size, Policy>::get_many(const size_type* a_Indice, size_type a_Count, const value_type** a_Out) const noexcept {
+    _get_many(a_Indice, a_Count, a_Out);
+}
+
+template<typename Type, uint32_t Size, typename Policy>
+void sparse_set<Type, Size, Policy>::prefetch(size_type a_Index) const noexcept {
+    _index.prefetch(a_Index);
+}
+
+template<typename Type, uint32_t Size, typename Policy>
+void sparse_set<Type, Size, Policy>::prefetch_value(size_type a_Index) const noexcept {
+    //clamped instead of tested so the prefetch doesn't wait on a branch
+    const auto pos = _index.find(std::min(a_Index, Size - 1));
+    _dense.prefetch(pos);
+}
+
+template<typename Type, uint32_t Size, typename Policy>
+template<typename Pointer>
+void sparse_set<Type, Size, Policy>::_get_many(const size_type* a_Indice, size_type a_Count, Pointer* a_Out) const noexcept {
+    static_assert(!soa && !aosoa, "get_many requires elements stored whole, use column() or for_each_block() with soa and aosoa storage");
+    constexpr size_type distance = Policy::prefetch_distance;
+    for (size_type i = 0; i < std::min(a_Count, distance); ++i) prefetch(a_Indice[i]);
+    for (size_type i = 0; i < a_Count; ++i) {
+        if (i + distance < a_Count) prefetch(a_Indice[i + distance]);
+        if (i + distance / 2 < a_Count) prefetch_value(a_Indice[i + distance / 2]);
+        const auto index = a_Indice[i];
+        const auto pos = index < Size ? _index.find(index) : max_size();
+        a_Out[i] = pos != max_size() ? (Pointer)&_dense.get(pos) : nullptr;
+    }
 }
+
+////////////////////////////////////////////////////////////////////////////////
+// Set algebra
+////////////////////////////////////////////////////////////////////////////////
+enum class sparse_set_operation {
+    intersect,  //indice in both sets
+    unite,      //indice in either set
+    subtract    //indice in the first set but not in the second one
+};
+
+/**
+* @brief Lazy range over the indice resulting from a set operation between two
+* sparse_sets of any value type and size. Iterating it walks the dense indice
+* of the smallest set that can drive the operation and probes the other one.
+* Iteration order is unspecified.
+*/
+template<sparse_set_operation Operation, typename SetA, typename SetB>
+class sparse_set_algebra {
+public:
+    using size_type = uint32_t;
+
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = size_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const size_type*;
+        using reference = const size_type&;
+
+        constexpr iterator() noexcept = default;
+        [[nodiscard]] constexpr reference operator*() const noexcept { return *_curr; }
+        constexpr iterator& operator++() { ++_curr; _skip(); return *this; }
+        constexpr iterator operator++(int) { auto tmp = *this; ++*this; return tmp; }
+        [[nodiscard]] constexpr bool operator==(const iterator& a_Other) const noexcept { return _curr == a_Other._curr && _segment == a_Other._segment; }
+        [[nodiscard]] constexpr bool operator!=(const iterator& a_Other) const noexcept { return !(*this == a_Other); }
+
+    private:
+        friend class sparse_set_algebra;
+        constexpr iterator(const sparse_set_algebra* a_Algebra, uint32_t a_Segment, const size_type* a_Curr)
+            : _algebra(a_Algebra), _segment(a_Segment), _curr(a_Curr) {}
+        constexpr void _skip() {
+            while (true) {
+                if (_curr == _algebra->_segments[_segment].end()) {
+                    if (_segment == 1) return;
+                    _curr = _algebra->_segments[++_segment].begin();
+                    continue;
+                }
+                if (_algebra->_accepts(_segment, *_curr)) return;
+                ++_curr;
+            }
+        }
+        const sparse_set_algebra* _algebra{ nullptr };
+        uint32_t _segment{ 1 };
+        const size_type* _curr{ nullptr };
+    };
+
+    constexpr sparse_set_algebra(const SetA& a_A, const SetB& a_B) noexcept;
+
+    [[nodiscard]] constexpr iterator begin() const;
+    [[nodiscard]] constexpr iterator end() const noexcept;
+
+    /**
+    * @brief Materializes the resulting indice. When both sets are dense over
+    * their key space, occupancy bitsets are combined word by word instead of probing.
+    */
+    [[nodiscard]] std::vector<size_type> collect() const;
+    /**
+    * @brief Inserts the resulting indice in a_Out, copying their values from the
+    * first set or from the second one for indice only it contains
+    */
+    template<typename Set>
+    void copy_to(Set& a_Out) const;
+
+private:
+    template<typename Set>
+    [[nodiscard]] static constexpr bool _has(const Set& a_Set, size_type a_Index) {
+        return a_Index < a_Set.max_size() && a_Set.contains(a_Index);
+    }
+    [[nodiscard]] constexpr bool _accepts(uint32_t a_Segment, size_type a_Index) const;
+    void _prefetch(uint32_t a_Segment, size_type a_Index) const noexcept;
+    [[nodiscard]] constexpr bool _dense() const noexcept;
+
+    const SetA& _a;
+    const SetB& _b;
+    bool _aDrives; //for intersections, true if _a is the smallest set
+    std::array<sparse_set_span<const size_type>, 2> _segments;
+};
+
+template<sparse_set_operation Operation, typename SetA, typename SetB>
+constexpr sparse_set_algebra<Operation, SetA, SetB>::sparse_set_algebra(const SetA& a_A, const SetB& a_B) noexcept
+    : _a(a_A), _b(a_B), _aDrives(a_A.size() <= a_B.size())
+{
+    if constexpr (Operation == sparse_set_operation::intersect) _segments[0] = _aDrives ? _a.keys() : _b.keys();
+    else _segments[0] = _a.keys();
+    if constexpr (Operation == sparse_set_operation::unite) _segments[1] = _b.keys();
+}
+
+template<sparse_set_operation Operation, typename SetA, typename SetB>
+constexpr auto sparse_set_algebra<Operation, SetA, SetB>::begin() const -> iterator {
+    iterator it(this, 0, _segments[0].begin());
+    it._skip();
+    return it;
+}
+
+template<sparse_set_operation Operation, typename SetA, typename SetB>
+constexpr auto sparse_set_algebra<Operation, SetA, SetB>::end() const noexcept -> iterator {
+    return iterator(this, 1, _segments[1].end());
+}
+
+template<sparse_set_operation Operation, typename SetA, typename SetB>
+constexpr bool sparse_set_algebra<Operation, SetA, SetB>::_accepts(uint32_t a_Segment, size_type a_Index) const {
+    if constexpr (Operation == sparse_set_operation::intersect)
+        return _aDrives ? _has(_b, a_Index) : _has(_a, a_Index);
+    else if constexpr (Operation == sparse_set_operation::subtract)
+        return !_has(_b, a_Index);
+    else
+        return a_Segment == 0 || !_has(_a, a_Index);
+}
+
+template<sparse_set_operation Operation, typename SetA, typename SetB>
+void sparse_set_algebra<Operation, SetA, SetB>::_prefetch(uint32_t a_Segment, size_type a_Index) const noexcept {
+    //prefetches the sparse slot _accepts will probe
+    if constexpr (Operation == sparse_set_operation::intersect) {
+        if (_aDrives) _b.prefetch(a_Index);
+        else _a.prefetch(a_Index);
+    }
+    else if constexpr (Operation == sparse_set_operation::subtract) _b.prefetch(a_Index);
+    else if (a_Segment == 1) _a.prefetch(a_Index);
+}
+
+template<sparse_set_operation Operation, typename SetA, typename SetB>
+constexpr bool sparse_set_algebra<Operation, SetA, SetB>::_dense() const noexcept {
+    //probing costs a random access per index, scanning bitsets costs a word per 64 possible indice
+    const size_type keySpace = std::max(_a.max_size(), _b.max_size());
+    return uint64_t(_a.size()) * 16 >= keySpace && uint64_t(_b.size()) * 16 >= keySpace;
+}
+
+template<sparse_set_operation Operation, typename SetA, typename SetB>
+auto sparse_set_algebra<Operation, SetA, SetB>::collect() const -> std::vector<size_type> {
+    std::vector<size_type> result;
+    if (!_dense()) {
+        //walk the segments by hand to probe prefetch_distance indice ahead
+        constexpr size_type distance = SetA::policy_type::prefetch_distance;
+        for (uint32_t segment = 0; segment < 2; ++segment) {
+            const auto keys = _segments[segment];
+            for (size_type i = 0; i < keys.size(); ++i) {
+                if (i + distance < keys.size()) _prefetch(segment, keys[i + distance]);
+                if (_accepts(segment, keys[i])) result.push_back(keys[i]);
+            }
+        }
+        return result;
+    }
+    const size_type wordCount = (std::max(_a.max_size(), _b.max_size()) + 63) / 64;
+    std::vector<uint64_t> bitsA(wordCount), bitsB(wordCount);
+    for (auto index : _a.keys()) bitsA[index / 64] |= uint64_t(1) << (index % 64);
+    for (auto index : _b.keys()) bitsB[index / 64] |= uint64_t(1) << (index % 64);
+    for (size_type word = 0; word < wordCount; ++word) {
+        uint64_t bits;
+        if constexpr (Operation == sparse_set_operation::intersect) bits = bitsA[word] & bitsB[word];
+        else if constexpr (Operation == sparse_set_operation::subtract) bits = bitsA[word] & ~bitsB[word];
+        else bits = bitsA[word] | bitsB[word];
+        for (; bits != 0; bits &= bits - 1)
+            result.push_back(word * 64 + size_type(sparse_set_detail::countr_zero(bits)));
+    }
+    return result;
+}
+
+template<sparse_set_operation Operation, typename SetA, typename SetB>
+template<typename Set>
+void sparse_set_algebra<Operation, SetA, SetB>::copy_to(Set& a_Out) const {
+    constexpr size_type distance = SetA::policy_type::prefetch_distance;
+    const auto keys = collect();
+    for (size_type i = 0; i < keys.size(); ++i) {
+        if (i + distance < keys.size()) {
+            _a.prefetch(keys[i + distance]);
+            if constexpr (Operation == sparse_set_operation::unite) _b.prefetch(keys[i + distance]);
+        }
+        if (i + distance / 2 < keys.size()) {
+            _a.prefetch_value(keys[i + distance / 2]);
+            if constexpr (Operation == sparse_set_operation::unite) _b.prefetch_value(keys[i + distance / 2]);
+        }
+        const auto index = keys[i];
+        if (Operation != sparse_set_operation::unite || _has(_a, index)) a_Out.insert(index, _a[index]);
+        else a_Out.insert(index, _b[index]);
+    }
+}
+
+/** @return a lazy range over the indice contained in both a_A and a_B */
+template<typename SetA, typename SetB>
+[[nodiscard]] constexpr auto sparse_set_intersect(const SetA& a_A, const SetB& a_B) noexcept {
+    return sparse_set_algebra<sparse_set_operation::intersect, SetA, SetB>(a_A, a_B);
+}
+
+/** @return a lazy range over the indice contained in a_A or a_B */
+template<typename SetA, typename SetB>
+[[nodiscard]] constexpr auto sparse_set_unite(const SetA& a_A, const SetB& a_B) noexcept {
+    return sparse_set_algebra<sparse_set_operation::unite, SetA, SetB>(a_A, a_B);
+}
+
+/** @return a lazy range over the indice contained in a_A but not in a_B */
+template<typename SetA, typename SetB>
+[[nodiscard]] constexpr auto sparse_set_subtract(const SetA& a_A, const SetB& a_B) noexcept {
+    return sparse_set_algebra<sparse_set_operation::subtract, SetA, SetB>(a_A, a_B);
+}
+
+/**
+* @brief Collects indice to erase from a_Set while it is being iterated,
+* erased at once by flush() or when the scope exits.
+* Debug builds assert if flush() is called while for_each walks a_Set.
+*/
+template<typename Set>
+class sparse_set_deferred_erase {
+public:
+    using size_type = typename Set::size_type;
+
+    explicit sparse_set_deferred_erase(Set& a_Set) noexcept : _set(a_Set) {}
+    sparse_set_deferred_erase(const sparse_set_deferred_erase&) = delete;
+    sparse_set_deferred_erase& operator=(const sparse_set_deferred_erase&) = delete;
+    ~sparse_set_deferred_erase() { flush(); }
+
+    /**
+    * @brief Queues the element at this index for erasure, queuing it twice is harmless.
+    * Out of bound indice throw here when the set would throw, so flushing in the destructor can't.
+    */
+    void erase(size_type a_Index) {
+        if constexpr (Set::policy_type::check == sparse_set_check::exception)
+            if (a_Index >= _set.max_size()) throw std::out_of_range("sparse_set_deferred_erase::erase: index out of bound");
+        _pending.push_back(a_Index);
+    }
+    /** @return the number of queued indice */
+    [[nodiscard]] size_type size() const noexcept { return size_type(_pending.size()); }
+    /** @brief Erases the queued elements with a single erase_many */
+    void flush() {
+        if (_pending.empty()) return;
+        _set.erase_many(_pending.data(), size());
+        _pending.clear();
+    }
+
+private:
+    Set& _set;
+    std::vector<size_type> _pending;
+};
@@ -0,0 +1,202 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include <sparse_set.hpp>
+
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// Class declarations
+////////////////////////////////////////////////////////////////////////////////
+/** @brief Identifies a type without RTTI, the address of a variable unique to each type */
+using sparse_set_type_id = const void*;
+
+namespace sparse_set_detail {
+template<typename Type>
+struct type_id_tag {
+    static constexpr char id{};
+};
+}
+
+/** @return the sparse_set_type_id of Type */
+template<typename Type>
+[[nodiscard]] constexpr sparse_set_type_id sparse_set_type_id_of() noexcept {
+    return &sparse_set_detail::type_id_tag<Type>::id;
+}
+
+/**
+* @brief Type-erased, non-owning view of a sparse_set of any value type.
+* Operations dispatch through function pointers stored in the handle itself,
+* so there is no vtable to load and bound checks are done inline.
+* Sets using tombstones can't be viewed as they have no keys().
+*/
+class sparse_set_handle {
+public:
+    using size_type = uint32_t;
+
+    template<typename Set>
+    explicit sparse_set_handle(Set& a_Set) noexcept;
+
+    /** @return the viewed set */
+    [[nodiscard]] void* get() const noexcept { return _set; }
+    /** @return The maximum number of elements that can be inserted in the set */
+    [[nodiscard]] size_type max_size() const noexcept { return _maxSize; }
+    /** @return The number of elements contained in the set */
+    [[nodiscard]] size_type size() const { return _size(_set); }
+    /** @return true if the set contains no element */
+    [[nodiscard]] bool empty() const { return size() == 0; }
+    /** @return true if a value is attached to this index, out of bound indice are absent */
+    [[nodiscard]] bool contains(size_type a_Index) const { return a_Index < _maxSize && _contains(_set, a_Index); }
+    /** @return the indice contained in the set, in dense order */
+    [[nodiscard]] sparse_set_span<const size_type> keys() const { return _keys(_set); }
+    /** @brief Removes the element at the specified index, out of bound indice are ignored */
+    void erase(size_type a_Index) { if (a_Index < _maxSize) _erase(_set, a_Index); }
+    /** @brief empties the set */
+    void clear() { _clear(_set); }
+
+private:
+    template<typename Set>
+    static size_type _size_of(const void* a_Set) { return ((const Set*)a_Set)->size(); }
+    template<typename Set>
+    static bool _contains_in(const void* a_Set, size_type a_Index) { return ((const Set*)a_Set)->contains_unchecked(a_Index); }
+    template<typename Set>
+    static sparse_set_span<const size_type> _keys_of(const void* a_Set) { return ((const Set*)a_Set)->keys(); }
+    template<typename Set>
+    static void _erase_from(void* a_Set, size_type a_Index) { ((Set*)a_Set)->erase(a_Index); }
+    template<typename Set>
+    static void _clear_of(void* a_Set) { ((Set*)a_Set)->clear(); }
+
+    void* _set;
+    size_type _maxSize;
+    size_type(*_size)(const void*);
+    bool(*_contains)(const void*, size_type);
+    sparse_set_span<const size_type>(*_keys)(const void*);
+    void(*_erase)(void*, size_type);
+    void(*_clear)(void*);
+};
+
+/**
+* @brief Owns one sparse_set<Type, Size, Policy> per Type, created on first use,
+* and applies index-wide operations to all of them through sparse_set_handle.
+* Sets are allocated on the heap and never move.
+*/
+template<uint32_t Size, typename Policy = sparse_set_policy>
+class sparse_set_registry {
+public:
+    using size_type = decltype(Size);
+    template<typename Type>
+    using set_type = sparse_set<Type, Size, Policy>;
+
+    sparse_set_registry() noexcept = default;
+    sparse_set_registry(const sparse_set_registry&) = delete;
+    sparse_set_registry& operator=(const sparse_set_registry&) = delete;
+    ~sparse_set_registry();
+
+    /** @return the set holding the Type elements, created if needed */
+    template<typename Type>
+    set_type<Type>& pool();
+    /** @return the set holding the Type elements, nullptr if it wasn't created */
+    template<typename Type>
+    [[nodiscard]] set_type<Type>* find_pool() const noexcept;
+    /**
+    * @brief Adds a set owned elsewhere, a runtime_sparse_set for instance, to the index-wide
+    * operations. It isn't returned by pool or find_pool and must outlive the registry.
+    */
+    template<typename Set>
+    void attach(Set& a_Set);
+    /** @return a handle to each set, in creation or attach order */
+    [[nodiscard]] sparse_set_span<const sparse_set_handle> pools() const noexcept;
+
+    /** @brief Removes the elements attached to this index from every set */
+    void erase(size_type a_Index);
+    /** @return true if every Types set contains an element at this index */
+    template<typename ...Types>
+    [[nodiscard]] bool contains(size_type a_Index) const noexcept;
+    /** @brief Empties every set */
+    void clear();
+
+private:
+    template<typename Type>
+    static void _delete(void* a_Set) { delete (set_type<Type>*)a_Set; }
+
+    std::vector<sparse_set_type_id> _types;
+    std::vector<sparse_set_handle> _handles;
+    std::vector<void(*)(void*)> _deleters; //nullptr for attached sets
+};
+
+template<typename Set>
+sparse_set_handle::sparse_set_handle(Set& a_Set) noexcept
+    : _set(&a_Set)
+    , _maxSize(a_Set.max_size())
+    , _size(&_size_of<Set>)
+    , _contains(&_contains_in<Set>)
+    , _keys(&_keys_of<Set>)
+    , _erase(&_erase_from<Set>)
+    , _clear(&_clear_of<Set>)
+{
+    static_assert(!Set::tombstones, "sparse_set_handle requires keys(), which sets using tombstones don't have");
+}
+
+template<uint32_t Size, typename Policy>
+sparse_set_registry<Size, Policy>::~sparse_set_registry() {
+    for (size_t i = 0; i < _handles.size(); ++i)
+        if (_deleters[i] != nullptr) _deleters[i](_handles[i].get());
+}
+
+template<uint32_t Size, typename Policy>
+template<typename Type>
+auto sparse_set_registry<Size, Policy>::pool() -> set_type<Type>& {
+    if (auto set = find_pool<Type>()) return *set;
+    _types.reserve(_types.size() + 1);
+    _handles.reserve(_handles.size() + 1);
+    _deleters.reserve(_deleters.size() + 1);
+    auto set = new set_type<Type>;
+    _types.push_back(sparse_set_type_id_of<Type>());
+    _handles.emplace_back(*set);
+    _deleters.push_back(&_delete<Type>);
+    return *set;
+}
+
+template<uint32_t Size, typename Policy>
+template<typename Set>
+void sparse_set_registry<Size, Policy>::attach(Set& a_Set) {
+    _types.reserve(_types.size() + 1);
+    _handles.reserve(_handles.size() + 1);
+    _deleters.reserve(_deleters.size() + 1);
+    _types.push_back(nullptr); //matches no type id
+    _handles.emplace_back(a_Set);
+    _deleters.push_back(nullptr); //not owned
+}
+
+template<uint32_t Size, typename Policy>
+template<typename Type>
+auto sparse_set_registry<Size, Policy>::find_pool() const noexcept -> set_type<Type>* {
+    const auto it = std::find(_types.begin(), _types.end(), sparse_set_type_id_of<Type>());
+    return it != _types.end() ? (set_type<Type>*)_handles[it - _types.begin()].get() : nullptr;
+}
+
+template<uint32_t Size, typename Policy>
+auto sparse_set_registry<Size, Policy>::pools() const noexcept -> sparse_set_span<const sparse_set_handle> {
+    return { _handles.data(), uint32_t(_handles.size()) };
+}
+
+template<uint32_t Size, typename Policy>
+void sparse_set_registry<Size, Policy>::erase(size_type a_Index) {
+    for (auto& handle : _handles) handle.erase(a_Index);
+}
+
+template<uint32_t Size, typename Policy>
+template<typename ...Types>
+bool sparse_set_registry<Size, Policy>::contains(size_type a_Index) const noexcept {
+    return ([&] {
+        const auto set = find_pool<Types>();
+        return set != nullptr && a_Index < Size && set->contains_unchecked(a_Index);
+    }() && ...);
+}
+
+template<uint32_t Size, typename Policy>
+void sparse_set_registry<Size, Policy>::clear() {
+    for (auto& handle : _handles) handle.clear();
+}
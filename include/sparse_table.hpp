@@ -0,0 +1,263 @@
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////////
+// Includes
+////////////////////////////////////////////////////////////////////////////////
+#include <sparse_set.hpp>
+
+#include <tuple>
+
+////////////////////////////////////////////////////////////////////////////////
+// Class declarations
+////////////////////////////////////////////////////////////////////////////////
+/**
+* @brief A sparse_set holding one element of each of Types per index.
+* The sparse array and dense indice are shared, each type gets its own
+* contiguous column and every column is kept in the same dense order, so
+* walking any subset of columns is a linear walk.
+* sizeof(sparse_table) is at least (sizeof(Types) + ...) * Size, large tables
+* should be allocated on the heap. Erasing invalidates references like sparse_set.
+*/
+template<uint32_t Size, typename ...Types>
+class sparse_table {
+public:
+    using size_type = decltype(Size);
+    static_assert(sizeof...(Types) > 0, "a sparse_table needs at least one column");
+
+    constexpr sparse_table() noexcept;
+    inline ~sparse_table() noexcept((std::is_nothrow_destructible_v<Types> && ...));
+
+    /** @return The maximum number of rows that can be inserted in the table */
+    [[nodiscard]] constexpr size_type max_size() const noexcept;
+    /** @return The number of rows contained in the table */
+    [[nodiscard]] constexpr size_type size() const noexcept;
+    /** @return true if the table contains no row */
+    [[nodiscard]] constexpr bool empty() const noexcept;
+    /** @return true if the number of rows in the table equals max_size() */
+    [[nodiscard]] constexpr bool full() const noexcept;
+    /** @brief empties the table */
+    constexpr void clear() noexcept((std::is_nothrow_destructible_v<Types> && ...));
+
+    /** @return true if a row is attached to this index */
+    constexpr bool contains(size_type a_Index) const;
+    /** @return the indice contained in the table, in dense order */
+    [[nodiscard]] constexpr sparse_set_span<const size_type> keys() const noexcept;
+
+    /** @return a ref to the Type element of the row at this index */
+    template<typename Type>
+    [[nodiscard]] constexpr Type& at(size_type a_Index);
+    /** @return a ref to the Type element of the row at this index */
+    template<typename Type>
+    [[nodiscard]] constexpr const Type& at(size_type a_Index) const;
+    /** @return *UNCHECKED* a ref to the Type element of the row at this index */
+    template<typename Type>
+    [[nodiscard]] constexpr Type& get(size_type a_Index) noexcept;
+    /** @return *UNCHECKED* a ref to the Type element of the row at this index */
+    template<typename Type>
+    [[nodiscard]] constexpr const Type& get(size_type a_Index) const noexcept;
+
+    /** @return the Type column, in dense order */
+    template<typename Type>
+    [[nodiscard]] constexpr sparse_set_span<Type> column() noexcept;
+    /** @return the Type column, in dense order */
+    template<typename Type>
+    [[nodiscard]] constexpr sparse_set_span<const Type> column() const noexcept;
+
+    /**
+    * @brief Inserts a new row at the specified index, replaces the current row if it already exists.
+    * Either takes one value per column or none to default construct every column.
+    * @return refs to the newly created elements
+    */
+    template<typename ...Args>
+    constexpr std::tuple<Types&...> insert(size_type a_Index, Args&&... a_Args);
+    /** @brief Removes the row at the specified index */
+    constexpr void erase(size_type a_Index)
+        noexcept((std::is_nothrow_destructible_v<Types> && ...));
+
+    /** @brief Calls a_Func(index, Columns&...) for each row in dense order */
+    template<typename ...Columns, typename Func>
+    constexpr void for_each(Func&& a_Func);
+
+private:
+    template<typename Type>
+    static constexpr size_t _column_index() noexcept;
+    template<typename ...Args, size_t ...Columns>
+    constexpr void _construct(size_type a_Pos, std::index_sequence<Columns...>, Args&&... a_Args);
+    constexpr void _destroy(size_type a_Pos) noexcept((std::is_nothrow_destructible_v<Types> && ...));
+    /** @brief Removes the row at this index, its elements must be destroyed already */
+    constexpr void _detach(size_type a_Index) noexcept;
+    constexpr std::tuple<Types&...> _row(size_type a_Pos) noexcept;
+
+    size_type _size{ 0 };
+    std::array<size_type, Size> _sparse;
+    std::array<size_type, Size> _keys; //the index of each row
+    std::tuple<sparse_set_detail::direct_storage<Types, Size>...> _columns;
+};
+
+template<uint32_t Size, typename ...Types>
+constexpr sparse_table<Size, Types...>::sparse_table() noexcept {
+    _sparse.fill(max_size());
+}
+
+template<uint32_t Size, typename ...Types>
+inline sparse_table<Size, Types...>::~sparse_table() noexcept((std::is_nothrow_destructible_v<Types> && ...)) {
+    clear();
+}
+
+template<uint32_t Size, typename ...Types>
+constexpr auto sparse_table<Size, Types...>::max_size() const noexcept -> size_type {
+    return Size;
+}
+
+template<uint32_t Size, typename ...Types>
+constexpr auto sparse_table<Size, Types...>::size() const noexcept -> size_type {
+    return _size;
+}
+
+template<uint32_t Size, typename ...Types>
+constexpr bool sparse_table<Size, Types...>::empty() const noexcept {
+    return _size == 0;
+}
+
+template<uint32_t Size, typename ...Types>
+constexpr bool sparse_table<Size, Types...>::full() const noexcept {
+    return _size == max_size();
+}
+
+template<uint32_t Size, typename ...Types>
+constexpr void sparse_table<Size, Types...>::clear() noexcept((std::is_nothrow_destructible_v<Types> && ...)) {
+    for (size_type pos = 0; pos < _size; ++pos) {
+        _sparse[_keys[pos]] = max_size();
+        _destroy(pos);
+    }
+    _size = 0;
+}
+
+template<uint32_t Size, typename ...Types>
+constexpr bool sparse_table<Size, Types...>::contains(size_type a_Index) const {
+    //if a_Index is out of bound we should crash here
+    return _sparse.at(a_Index) != max_size();
+}
+
+template<uint32_t Size, typename ...Types>
+constexpr auto sparse_table<Size, Types...>::keys() const noexcept -> sparse_set_span<const size_type> {
+    return { _keys.data(), _size };
+}
+
+template<uint32_t Size, typename ...Types>
+template<typename Type>
+constexpr Type& sparse_table<Size, Types...>::at(size_type a_Index) {
+    if (!contains(a_Index)) throw std::out_of_range("sparse_table::at: no row at this index");
+    return get<Type>(a_Index);
+}
+
+template<uint32_t Size, typename ...Types>
+template<typename Type>
+constexpr const Type& sparse_table<Size, Types...>::at(size_type a_Index) const {
+    if (!contains(a_Index)) throw std::out_of_range("sparse_table::at: no row at this index");
+    return get<Type>(a_Index);
+}
+
+template<uint32_t Size, typename ...Types>
+template<typename Type>
+constexpr Type& sparse_table<Size, Types...>::get(size_type a_Index) noexcept {
+    return std::get<_column_index<Type>()>(_columns).get(_sparse[a_Index]);
+}
+
+template<uint32_t Size, typename ...Types>
+template<typename Type>
+constexpr const Type& sparse_table<Size, Types...>::get(size_type a_Index) const noexcept {
+    return std::get<_column_index<Type>()>(_columns).get(_sparse[a_Index]);
+}
+
+template<uint32_t Size, typename ...Types>
+template<typename Type>
+constexpr sparse_set_span<Type> sparse_table<Size, Types...>::column() noexcept {
+    return { std::get<_column_index<Type>()>(_columns).data(0), _size };
+}
+
+template<uint32_t Size, typename ...Types>
+template<typename Type>
+constexpr sparse_set_span<const Type> sparse_table<Size, Types...>::column() const noexcept {
+    return { &std::get<_column_index<Type>()>(_columns).get(0), _size };
+}
+
+template<uint32_t Size, typename ...Types>
+template<typename ...Args>
+constexpr auto sparse_table<Size, Types...>::insert(size_type a_Index, Args&&... a_Args) -> std::tuple<Types&...> {
+    static_assert(sizeof...(Args) == 0 || sizeof...(Args) == sizeof...(Types), "insert takes one value per column or none");
+    if (contains(a_Index)) { //just replace the row
+        const auto pos = _sparse[a_Index];
+        _destroy(pos);
+        //the old row is gone, if the new one can't be built the index is left empty
+        sparse_set_detail::rollback undo([&] { _detach(a_Index); });
+        _construct(pos, std::index_sequence_for<Types...>{}, std::forward<Args>(a_Args)...);
+        undo.dismiss();
+        return _row(pos);
+    }
+    if (full()) throw std::out_of_range("sparse_table::insert: the table is full");
+    _construct(_size, std::index_sequence_for<Types...>{}, std::forward<Args>(a_Args)...);
+    _sparse[a_Index] = _size;
+    _keys[_size] = a_Index;
+    return _row(_size++);
+}
+
+template<uint32_t Size, typename ...Types>
+constexpr void sparse_table<Size, Types...>::erase(size_type a_Index)
+    noexcept((std::is_nothrow_destructible_v<Types> && ...))
+{
+    if (empty() || !contains(a_Index)) return;
+    _destroy(_sparse[a_Index]);
+    _detach(a_Index);
+}
+
+template<uint32_t Size, typename ...Types>
+constexpr void sparse_table<Size, Types...>::_detach(size_type a_Index) noexcept {
+    _size--;
+    const size_type currPos = _sparse[a_Index];
+    const size_type lastIndex = _keys[_size];
+    if (currPos != _size) //crush current row with last row, in every column
+        std::apply([&](auto&... a_Columns) { (a_Columns.relocate(_size, currPos), ...); }, _columns);
+    _keys[currPos] = lastIndex;
+    _sparse[lastIndex] = currPos;
+    _sparse[a_Index] = max_size();
+}
+
+template<uint32_t Size, typename ...Types>
+template<typename ...Columns, typename Func>
+constexpr void sparse_table<Size, Types...>::for_each(Func&& a_Func) {
+    auto columns = std::make_tuple(column<Columns>().data()...);
+    for (size_type pos = 0; pos < _size; ++pos)
+        a_Func(_keys[pos], std::get<Columns*>(columns)[pos]...);
+}
+
+template<uint32_t Size, typename ...Types>
+template<typename Type>
+constexpr size_t sparse_table<Size, Types...>::_column_index() noexcept {
+    static_assert((std::is_same_v<Type, Types> + ...) == 1, "the type must appear exactly once in the table");
+    constexpr bool matches[] = { std::is_same_v<Type, Types>... };
+    size_t index = 0;
+    while (index < sizeof...(Types) && !matches[index]) ++index;
+    return index;
+}
+
+template<uint32_t Size, typename ...Types>
+template<typename ...Args, size_t ...Columns>
+constexpr void sparse_table<Size, Types...>::_construct(size_type a_Pos, std::index_sequence<Columns...>, Args&&... a_Args) {
+    size_t built = 0;
+    //destroys the columns already built if a later one throws
+    sparse_set_detail::rollback undo([&] { ((Columns < built ? std::get<Columns>(_columns).destroy(a_Pos) : void()), ...); });
+    if constexpr (sizeof...(Args) == 0) ((std::get<Columns>(_columns).construct(a_Pos), ++built), ...);
+    else ((std::get<Columns>(_columns).construct(a_Pos, std::forward<Args>(a_Args)), ++built), ...);
+    undo.dismiss();
+}
+
+template<uint32_t Size, typename ...Types>
+constexpr void sparse_table<Size, Types...>::_destroy(size_type a_Pos) noexcept((std::is_nothrow_destructible_v<Types> && ...)) {
+    std::apply([a_Pos](auto&... a_Columns) { (a_Columns.destroy(a_Pos), ...); }, _columns);
+}
+
+template<uint32_t Size, typename ...Types>
+constexpr auto sparse_table<Size, Types...>::_row(size_type a_Pos) noexcept -> std::tuple<Types&...> {
+    return std::apply([a_Pos](auto&... a_Columns) { return std::tuple<Types&...>(a_Columns.get(a_Pos)...); }, _columns);
+}
@@ -1,11 +1,870 @@
 #include <sparse_set.hpp>
+#include <frozen_sparse_set.hpp>
+#include <sparse_id_allocator.hpp>
+#include <sparse_set_registry.hpp>
+#include <runtime_sparse_set.hpp>
+#include <sparse_table.hpp>
 
+#include <algorithm>
 #include <cassert>
+#include <string>
 
 struct Transform {
     std::array<float, 3> position{ 0, 0, 0 };
 };
 
+struct tracked_policy : sparse_set_policy {
+    static constexpr bool track_changes = true;
+};
+
+void test_delta()
+{
+    auto source = new sparse_set<int, 256, tracked_policy>;
+    auto replica = new sparse_set<int, 256>;
+    source->insert(1, 10);
+    source->insert(2, 20);
+    auto full = source->make_delta(0);
+    assert(full.inserted.size() == 2 && full.modified.empty() && full.erased.empty());
+    replica->apply_delta(full);
+    assert(replica->size() == 2 && replica->at(1) == 10 && replica->at(2) == 20);
+
+    assert(source->make_delta(full.epoch).empty());
+    source->insert(3, 30);
+    source->modify(1) = 11;
+    source->erase(2);
+    source->insert(200, 1);
+    source->erase(200);
+    auto delta = source->make_delta(full.epoch);
+    assert(delta.inserted.size() == 1 && delta.inserted[0].first == 3);
+    assert(delta.modified.size() == 1 && delta.modified[0].first == 1);
+    assert(delta.erased.size() == 2);
+    replica->apply_delta(delta);
+    assert(replica->size() == 2 && replica->at(1) == 11 && replica->at(3) == 30);
+    assert(!replica->contains(2) && !replica->contains(200));
+    delete replica;
+    delete source;
+}
+
+struct counting_observer : sparse_set_observer<counting_observer> {
+    uint32_t inserted = 0, replaced = 0, erased = 0, batches = 0;
+    template<typename Set> void on_insert(Set&, uint32_t) { inserted++; }
+    template<typename Set> void on_replace(Set&, uint32_t) { replaced++; }
+    template<typename Set> void on_erase(Set& a_Set, uint32_t a_Index) { assert(a_Set.contains(a_Index)); erased++; }
+    template<typename Set> void on_insert_many(Set& a_Set, const uint32_t* a_Indice, uint32_t a_Count) {
+        batches++;
+        sparse_set_observer::on_insert_many(a_Set, a_Indice, a_Count);
+    }
+};
+
+struct observed_policy : sparse_set_policy {
+    using observer_type = counting_observer;
+};
+
+void test_observer()
+{
+    static_assert(sizeof(sparse_set<int, 16>) == sizeof(sparse_set<int, 16, observed_policy>) - sizeof(uint32_t) * 4);
+    sparse_set<int, 16, observed_policy> set;
+    auto& observer = set.observer();
+    set.insert(1, 1);
+    set.insert(1, 2);
+    set.erase(1);
+    set.erase(1);
+    assert(observer.inserted == 1 && observer.replaced == 1 && observer.erased == 1);
+    const uint32_t indice[] = { 2, 3, 4, 3 };
+    set.insert_many(indice, 4, 42);
+    assert(observer.batches == 1 && observer.inserted == 4 && observer.replaced == 2);
+    assert(set.size() == 3 && set[3] == 42);
+    set.clear();
+    assert(observer.erased == 4 && set.empty());
+    set.insert(1, 1);
+    const uint32_t erased[] = { 1, 1, 2 }; //only one of them is contained
+    set.erase_many(erased, 3);
+    assert(observer.erased == 5 && set.empty());
+}
+
+void test_contains_many()
+{
+    auto set = new sparse_set<int, 2048>;
+    uint32_t indice[150];
+    for (uint32_t i = 0; i < 150; ++i) {
+        indice[i] = i * 7;
+        if (i % 2) set->insert(indice[i], int(i));
+    }
+    indice[149] = 0xFFFFFFFFu; //out of bound
+    uint64_t bits[3];
+    uint32_t dense[150];
+    assert(set->contains_many(indice, 150, bits) == 74);
+    set->find_many(indice, 150, dense);
+    for (uint32_t i = 0; i < 150; ++i) {
+        const bool contained = (bits[i / 64] >> (i % 64)) & 1;
+        assert(contained == (i % 2 && i != 149));
+        assert(contained ? (*set)[indice[i]] == int(i) : dense[i] == set->max_size());
+        if (contained) assert(dense[i] < set->size());
+    }
+    delete set;
+}
+
+void test_get_many()
+{
+    auto set = new sparse_set<Transform, 65536>;
+    std::vector<uint32_t> indice;
+    for (uint32_t i = 0; i < 1000; ++i) {
+        indice.push_back((i * 7919u) % 70000u);
+        if (i % 4 && indice.back() < set->max_size()) set->insert(indice.back()).position[0] = float(i);
+    }
+    std::vector<Transform*> values(indice.size());
+    set->get_many(indice.data(), uint32_t(indice.size()), values.data());
+    for (uint32_t i = 0; i < indice.size(); ++i) {
+        if (indice[i] < set->max_size() && set->contains(indice[i])) assert(values[i] == &set->at(indice[i]));
+        else assert(values[i] == nullptr);
+    }
+    delete set;
+}
+
+void test_algebra()
+{
+    auto a = new sparse_set<int, 4096>;
+    auto b = new sparse_set<float, 2048>;
+    for (uint32_t i = 0; i < 4096; i += 2) a->insert(i, int(i));
+    for (uint32_t i = 0; i < 2048; i += 3) b->insert(i, float(i));
+    auto check = [](std::vector<uint32_t> a_Keys, auto a_Predicate, uint32_t a_Max) {
+        std::sort(a_Keys.begin(), a_Keys.end());
+        std::vector<uint32_t> expected;
+        for (uint32_t i = 0; i < a_Max; ++i) if (a_Predicate(i)) expected.push_back(i);
+        assert(a_Keys == expected);
+    };
+    auto lazy = [](auto a_Range) { return std::vector<uint32_t>(a_Range.begin(), a_Range.end()); };
+    auto inBoth = [](uint32_t i) { return i % 2 == 0 && i % 3 == 0 && i < 2048; };
+    auto inEither = [](uint32_t i) { return i % 2 == 0 || (i % 3 == 0 && i < 2048); };
+    auto inFirst = [](uint32_t i) { return i % 2 == 0 && !(i % 3 == 0 && i < 2048); };
+    //dense sets take the bitset path when collected
+    check(sparse_set_intersect(*a, *b).collect(), inBoth, 4096);
+    check(sparse_set_unite(*a, *b).collect(), inEither, 4096);
+    check(sparse_set_subtract(*a, *b).collect(), inFirst, 4096);
+    check(lazy(sparse_set_intersect(*a, *b)), inBoth, 4096);
+    check(lazy(sparse_set_unite(*a, *b)), inEither, 4096);
+    check(lazy(sparse_set_subtract(*a, *b)), inFirst, 4096);
+
+    auto sparse = new sparse_set<float, 2048>;
+    sparse->insert(6, 1.f);
+    sparse->insert(7, 1.f);
+    check(sparse_set_intersect(*a, *sparse).collect(), [](uint32_t i) { return i == 6; }, 4096);
+    auto result = new sparse_set<int, 4096>;
+    sparse_set_unite(*sparse, *a).copy_to(*result);
+    assert(result->size() == a->size() + 1 && result->at(7) == 1 && result->at(6) == 1 && result->at(8) == 8);
+    delete result;
+    delete sparse;
+    delete b;
+    delete a;
+}
+
+struct AIState {
+    std::array<uint64_t, 64> memory{};
+    std::vector<int> path;
+};
+
+void test_indirect_storage()
+{
+    using set_type = sparse_set<AIState, 4096>;
+    static_assert(set_type::indirect && !sparse_set<Transform, 4096>::indirect);
+    static_assert(sizeof(set_type) < sizeof(AIState) * 4096 / 16);
+    auto set = new set_type;
+    for (uint32_t i = 0; i < 1000; ++i) {
+        auto& state = set->insert(i * 4);
+        state.memory[0] = i;
+        state.path.assign(i % 5, int(i));
+    }
+    auto kept = &set->at(3996);
+    for (uint32_t i = 0; i < 1000; i += 2) set->erase(i * 4);
+    assert(set->size() == 500 && kept == &set->at(3996)); //elements never move in memory
+    for (uint32_t i = 0; i < 1000; ++i) {
+        assert(set->contains(i * 4) == (i % 2 == 1));
+        if (i % 2) assert(set->at(i * 4).memory[0] == i && set->at(i * 4).path.size() == i % 5);
+    }
+    for (uint32_t i = 0; i < 500; ++i) set->insert(i * 2 + 1).memory[0] = i; //reuses released slots
+    assert(set->size() == 1000 && set->at(999).memory[0] == 499);
+    delete set;
+}
+
+struct stable_policy : sparse_set_policy {
+    static constexpr sparse_set_erase erase = sparse_set_erase::tombstone;
+    using observer_type = counting_observer;
+};
+
+void test_tombstones()
+{
+    auto set = new sparse_set<Transform, 1024, stable_policy>;
+    for (uint32_t i = 0; i < 200; ++i) set->insert(i).position[0] = float(i);
+    auto kept = &set->at(199);
+    for (uint32_t i = 0; i < 200; i += 3) set->erase(i);
+    assert(kept == &set->at(199) && set->size() == 133);
+    uint32_t visited = 0;
+    set->for_each([&](uint32_t a_Index, Transform& a_Value) {
+        assert(a_Index % 3 && a_Value.position[0] == float(a_Index));
+        visited++;
+    });
+    assert(visited == 133);
+    set->insert(1000).position[0] = 1000; //reuses the slot 198 was erased from
+    assert(&set->at(1000) == &set->at(1) + 197);
+    assert(kept == &set->at(199));
+    set->compact();
+    std::vector<uint32_t> order;
+    set->for_each([&](uint32_t a_Index, const Transform& a_Value) {
+        assert(a_Value.position[0] == float(a_Index));
+        order.push_back(a_Index);
+    });
+    assert(order.size() == 134 && &set->at(order[0]) + 133 == &set->at(order[133]));
+    set->clear();
+    assert(set->empty() && set->observer().erased == 67 + 134);
+    delete set;
+
+    sparse_set<std::string, 16, stable_policy> strings; //short strings point into themselves
+    for (uint32_t i = 0; i < 4; ++i) strings.insert(i, std::string(1, char('a' + i)));
+    strings.erase(0);
+    strings.compact();
+    strings.at(3) = "z";
+    assert(strings.size() == 3 && strings.at(1) == "b" && strings.at(3) == "z");
+}
+
+struct paged_policy : sparse_set_policy {
+    static constexpr sparse_set_storage storage = sparse_set_storage::paged;
+    static constexpr uint32_t page_size = 256;
+};
+
+void test_paged_storage()
+{
+    using set_type = sparse_set<Transform, 10000, paged_policy>;
+    static_assert(sizeof(set_type) < sizeof(Transform) * 10000);
+    auto set = new set_type;
+    for (uint32_t i = 0; i < 1000; ++i) set->insert(i * 10).position[0] = float(i);
+    auto first = &set->at(0);
+    for (uint32_t i = 1000; i < 1300; ++i) set->insert(i * 7 + 3).position[0] = float(i);
+    assert(first == &set->at(0)); //growing allocated new pages without moving the others
+    for (uint32_t i = 0; i < 1000; i += 2) set->erase(i * 10);
+    uint32_t count = 0, pages = 0;
+    set->for_each_page([&](const uint32_t* a_Indice, Transform* a_Values, uint32_t a_Count) {
+        assert(a_Count <= 256);
+        for (uint32_t i = 0; i < a_Count; ++i) assert(&set->at(a_Indice[i]) == a_Values + i);
+        count += a_Count;
+        pages++;
+    });
+    assert(count == set->size() && pages == (count + 255) / 256);
+    delete set;
+}
+
+struct Selected {};
+
+void test_tags()
+{
+    static_assert(sparse_set<Selected, 1024>::tagged && sparse_set<void, 1024>::tagged);
+    static_assert(sizeof(sparse_set<Selected, 1024>) == sizeof(uint32_t) * (1 + 1024 * 2));
+    static_assert(sizeof(sparse_set<void, 1024>) == sizeof(sparse_set<Selected, 1024>));
+    sparse_set<void, 1024> set;
+    for (uint32_t i = 0; i < 1024; i += 2) set.insert(i);
+    for (uint32_t i = 0; i < 1024; i += 4) set.erase(i);
+    assert(set.size() == 256);
+    for (uint32_t i = 0; i < 1024; ++i) assert(set.contains(i) == (i % 4 == 2));
+    uint32_t visited = 0;
+    set.for_each([&](uint32_t a_Index, sparse_set_tag&) { assert(a_Index % 4 == 2); visited++; });
+    assert(visited == 256);
+}
+
+struct Velocity {
+    float x, y, z;
+};
+
+//throws when built from "throw", to check a failed insert leaves the set untouched
+struct Fragile {
+    std::string name;
+    Fragile(const char* a_Name) : name(a_Name) {
+        if (name == "throw") throw std::runtime_error("Fragile");
+    }
+};
+
+template<typename Set>
+void test_throwing_insert(Set& a_Set)
+{
+    bool thrown = false;
+    try { a_Set.insert(0, "throw"); }
+    catch (const std::runtime_error&) { thrown = true; }
+    assert(thrown && !a_Set.contains(0));
+}
+
+void test_table()
+{
+    auto table = new sparse_table<4096, Transform, Velocity, int>;
+    for (uint32_t i = 0; i < 100; ++i) {
+        auto [transform, velocity, health] = table->insert(i * 3);
+        transform.position[0] = float(i);
+        velocity = { float(i), 1, 0 };
+        health = int(i);
+    }
+    table->insert(3, Transform{ { 1, 0, 0 } }, Velocity{ 1, 2, 0 }, 1);
+    for (uint32_t i = 0; i < 100; i += 2) table->erase(i * 3);
+    assert(table->size() == 50 && !table->contains(0) && table->at<Velocity>(3).y == 2);
+    table->for_each<Transform, Velocity>([](uint32_t a_Index, Transform& a_Transform, Velocity& a_Velocity) {
+        assert(a_Transform.position[0] == float(a_Index / 3) && a_Velocity.x == a_Transform.position[0]);
+        a_Transform.position[0] += a_Velocity.x;
+    });
+    auto keys = table->keys();
+    auto health = table->column<int>();
+    for (uint32_t pos = 0; pos < keys.size(); ++pos) {
+        assert(health[pos] == int(keys[pos] / 3));
+        assert(table->get<Transform>(keys[pos]).position[0] == float(health[pos] * 2));
+    }
+    delete table;
+
+    sparse_table<16, std::string, Fragile> fragile;
+    bool thrown = false;
+    try { fragile.insert(1, std::string(32, 'a'), "throw"); } //the built string column must be destroyed
+    catch (const std::runtime_error&) { thrown = true; }
+    assert(thrown && !fragile.contains(1) && fragile.empty());
+    fragile.insert(1, std::string(32, 'a'), "ok");
+    fragile.insert(2, std::string(32, 'b'), "ok");
+    thrown = false;
+    try { fragile.insert(1, std::string(32, 'c'), "throw"); } //the replaced row is removed
+    catch (const std::runtime_error&) { thrown = true; }
+    assert(thrown && !fragile.contains(1) && fragile.size() == 1 && fragile.get<Fragile>(2).name == "ok");
+}
+
+struct Particle {
+    float x, y, z;
+    std::array<float, 3> color;
+    int id;
+};
+
+struct soa_policy : sparse_set_policy {
+    static constexpr sparse_set_storage storage = sparse_set_storage::soa;
+};
+
+void test_soa_storage()
+{
+    static_assert(sparse_set_detail::field_count<Particle>() == 5);
+    static_assert(sparse_set_detail::field_count<Transform>() == 1);
+    auto set = new sparse_set<Particle, 1024, soa_policy>;
+    for (uint32_t i = 0; i < 100; ++i) set->insert(i * 2, Particle{ float(i), 0, 0, { 1, 1, 1 }, int(i) });
+    for (uint32_t i = 0; i < 100; i += 2) set->erase(i * 2);
+    auto x = set->column<0>();
+    auto id = set->column<4>();
+    assert(x.size() == 50);
+    for (uint32_t pos = 0; pos < x.size(); ++pos) {
+        assert(x[pos] == float(id[pos]) && set->keys()[pos] == uint32_t(id[pos] * 2));
+        x[pos] += 1;
+    }
+    Particle particle = set->at(2);
+    assert(particle.x == 2 && particle.id == 1 && particle.color[2] == 1);
+    (*set)[2] = Particle{ 0, 1, 2, { 3, 4, 5 }, 6 };
+    assert(set->at(2).get<1>() == 1 && set->at(2).get<3>()[2] == 5);
+    set->modify(2).get<4>() = 7;
+    assert(Particle(std::as_const(*set)[2]).id == 7);
+    delete set;
+}
+
+struct aosoa_policy : sparse_set_policy {
+    static constexpr sparse_set_storage storage = sparse_set_storage::aosoa;
+};
+
+void test_aosoa_storage()
+{
+    auto set = new sparse_set<Particle, 1024, aosoa_policy>;
+    for (uint32_t i = 0; i < 100; ++i) set->insert(i * 3, Particle{ float(i), 0, 0, { 1, 1, 1 }, int(i) });
+    for (uint32_t i = 0; i < 100; i += 3) set->erase(i * 3);
+    uint32_t count = 0;
+    set->for_each_block([&](const uint32_t* a_Keys, auto a_Fields, uint32_t a_Count) {
+        assert(a_Count <= aosoa_policy::block_size);
+        auto x = std::get<0>(a_Fields);
+        auto y = std::get<1>(a_Fields);
+        auto id = std::get<4>(a_Fields);
+        for (uint32_t i = 0; i < a_Count; ++i) {
+            assert(x[i] == float(id[i]) && a_Keys[i] == uint32_t(id[i] * 3));
+            y[i] = x[i] * 2;
+        }
+        count += a_Count;
+    });
+    assert(count == set->size() && count == 66);
+    set->for_each([](uint32_t a_Index, auto a_Particle) { assert(a_Particle.template get<1>() == float(a_Index / 3 * 2)); });
+    Particle particle = set->at(6);
+    assert(particle.y == 4 && particle.id == 2 && particle.color[0] == 1);
+    delete set;
+}
+
+struct ranked_policy : sparse_set_policy {
+    static constexpr sparse_set_lookup lookup = sparse_set_lookup::rank;
+};
+
+void test_rank_lookup()
+{
+    static_assert(sizeof(sparse_set<int, 4096, ranked_policy>) < sizeof(sparse_set<int, 4096>) - 4096 * 3);
+    auto set = new sparse_set<int, 4096, ranked_policy>;
+    for (uint32_t i = 0; i < 1000; ++i) set->insert((i * 2654435761u) % 4096, int((i * 2654435761u) % 4096));
+    for (uint32_t i = 0; i < 4096; i += 3) set->erase(i);
+    uint32_t previous = 0, count = 0;
+    set->for_each([&](uint32_t a_Index, int& a_Value) {
+        assert(count == 0 || a_Index > previous);
+        assert(a_Value == int(a_Index) && a_Index % 3 != 0);
+        previous = a_Index;
+        count++;
+    });
+    assert(count == set->size() && std::is_sorted(set->keys().begin(), set->keys().end()));
+    for (uint32_t i = 0; i < 4096; ++i) assert(!set->contains(i) || set->at(i) == int(i));
+    const uint32_t indice[] = { 1, 3, set->keys()[10], 5000 };
+    uint32_t positions[4];
+    set->find_many(indice, 4, positions);
+    assert(positions[2] == 10 && positions[3] == set->max_size());
+    set->clear();
+    assert(set->empty() && !set->contains(indice[2]));
+    delete set;
+
+    sparse_set<std::string, 16, ranked_policy> strings; //short strings point into themselves
+    strings.insert(2, "b");
+    strings.insert(1, "a");
+    strings.at(2) = "z";
+    strings.insert(0, "0");
+    strings.erase(1);
+    assert(strings.size() == 2 && strings.at(0) == "0" && strings.at(2) == "z");
+
+    sparse_set<Fragile, 16, ranked_policy> fragile;
+    fragile.insert(1, "a");
+    fragile.insert(2, "b");
+    test_throwing_insert(fragile);
+    assert(fragile.size() == 2 && fragile.at(1).name == "a" && fragile.at(2).name == "b");
+}
+
+struct paged_ranked_policy : ranked_policy {
+    static constexpr sparse_set_storage storage = sparse_set_storage::paged;
+    static constexpr uint32_t page_size = 4;
+};
+
+void test_paged_rank_lookup()
+{
+    sparse_set<int, 64, paged_ranked_policy> set;
+    for (uint32_t i = 1; i <= 4; ++i) set.insert(i, int(i));
+    set.insert(0, 0); //shifts the first page into the second, not allocated yet
+    for (uint32_t i = 0; i <= 4; ++i) assert(set.keys()[i] == i && set.at(i) == int(i));
+}
+
+struct ordered_policy : sparse_set_policy {
+    static constexpr bool ordered_iteration = true;
+    static constexpr sparse_set_erase erase = sparse_set_erase::tombstone;
+};
+
+void test_ordered_iteration()
+{
+    auto set = new sparse_set<int, 65536, ordered_policy>;
+    std::vector<uint32_t> expected;
+    for (uint32_t i = 0; i < 2000; ++i) {
+        const uint32_t index = (i * 2654435761u) % 65536;
+        set->insert(index, int(index));
+        if (index % 5 == 0) set->erase(index);
+        else expected.push_back(index);
+    }
+    std::sort(expected.begin(), expected.end());
+    std::vector<uint32_t> visited;
+    set->for_each_ordered([&](uint32_t a_Index, int& a_Value) { assert(a_Value == int(a_Index)); visited.push_back(a_Index); });
+    assert(visited == expected);
+    visited.clear();
+    std::as_const(*set).for_each_ordered(1000, 40000, [&](uint32_t a_Index, const int&) { visited.push_back(a_Index); });
+    const auto first = std::lower_bound(expected.begin(), expected.end(), 1000u);
+    const auto last = std::lower_bound(expected.begin(), expected.end(), 40000u);
+    assert(std::equal(visited.begin(), visited.end(), first, last) && visited.size() == size_t(last - first));
+    delete set;
+
+    auto ranked = new sparse_set<int, 4096, ranked_policy>;
+    for (uint32_t i = 100; i > 0; --i) ranked->insert(i * 7, int(i));
+    uint32_t count = 0;
+    ranked->for_each_ordered(70, 140, [&](uint32_t a_Index, int& a_Value) {
+        assert(a_Index == 70 + count * 7 && a_Value == int(a_Index / 7));
+#ifndef NDEBUG
+        assert(sparse_set_detail::iteration_guard::iterating(ranked)); //erasing here would assert
+#endif
+        count++;
+    });
+    assert(count == 10);
+#ifndef NDEBUG
+    assert(!sparse_set_detail::iteration_guard::iterating(ranked));
+#endif
+    delete ranked;
+}
+
+void test_freeze()
+{
+    auto set = new sparse_set<int, 65536>;
+    for (uint32_t i = 0; i < 5000; ++i) set->insert((i * 2654435761u) % 65536, int(i));
+    for (uint32_t i = 0; i < 5000; i += 4) set->erase((i * 2654435761u) % 65536);
+    const auto frozen = sparse_set_freeze(*set);
+    assert(frozen.size() == set->size());
+    for (uint32_t i = 0; i < 65536; ++i) {
+        assert(frozen.contains(i) == set->contains(i));
+        if (set->contains(i)) assert(frozen.at(i) == set->at(i) && *frozen.find(i) == set->at(i));
+        else assert(frozen.find(i) == nullptr);
+    }
+    assert(!frozen.contains(70000) && (frozen_sparse_set<int, 16>().find(3) == nullptr));
+    uint32_t count = 0;
+    frozen.for_each([&](uint32_t a_Index, const int& a_Value) { assert(set->at(a_Index) == a_Value); count++; });
+    assert(count == frozen.size());
+    auto thawed = new sparse_set<int, 65536>;
+    thawed->insert(1, 1);
+    frozen.thaw(*thawed);
+    assert(thawed->size() == set->size());
+    set->for_each([&](uint32_t a_Index, int& a_Value) { assert(thawed->at(a_Index) == a_Value); });
+    delete thawed;
+    delete set;
+
+    auto particles = new sparse_set<Particle, 1024, soa_policy>;
+    for (uint32_t i = 0; i < 10; ++i) particles->insert(i * 3, Particle{ float(i), 0, 0, { 1, 1, 1 }, int(i) });
+    const auto frozenParticles = sparse_set_freeze(*particles);
+    assert(frozenParticles.at(9).id == 3 && !frozenParticles.contains(10));
+    delete particles;
+
+    //tags and void only keep the indice
+    sparse_set<void, 1024> marked;
+    marked.insert(7);
+    marked.insert(3);
+    const auto frozenMarks = sparse_set_freeze(marked);
+    static_assert(decltype(frozenMarks)::tagged && frozen_sparse_set<Selected, 1024>::tagged);
+    assert(frozenMarks.size() == 2 && frozenMarks.contains(3) && frozenMarks.find(7) && !frozenMarks.find(4));
+    sparse_set<void, 1024> thawedMarks;
+    frozenMarks.thaw(thawedMarks);
+    assert(thawedMarks.size() == 2 && thawedMarks.contains(7));
+}
+
+struct masked_policy : sparse_set_policy {
+    static constexpr sparse_set_check check = sparse_set_check::mask;
+};
+
+struct unchecked_policy : sparse_set_policy {
+    static constexpr sparse_set_check check = sparse_set_check::none;
+};
+
+void test_checks()
+{
+    auto checked = new sparse_set<int, 256>;
+    bool thrown = false;
+    try { checked->insert(256, 1); }
+    catch (const std::out_of_range&) { thrown = true; }
+    assert(thrown && checked->empty() && !checked->contains_unchecked(0));
+    delete checked;
+
+    auto masked = new sparse_set<int, 256, masked_policy>;
+    masked->insert(256 + 3, 1);
+    assert(masked->contains(3) && masked->contains(512 + 3) && masked->at(768 + 3) == 1);
+    masked->erase(1024 + 3);
+    assert(masked->empty());
+    delete masked;
+
+    auto unchecked = new sparse_set<int, 256, unchecked_policy>;
+    unchecked->insert(255, 1);
+    assert(unchecked->contains(255) && unchecked->contains_unchecked(255) && !unchecked->contains(254));
+    delete unchecked;
+}
+
+void test_find()
+{
+    auto set = new sparse_set<std::string, 1024, observed_policy>;
+    assert(set->find(3) == nullptr && set->find_dense(3) == set->max_size());
+    set->get_or_insert(3, "three");
+    assert(set->get_or_insert(3, "ignored") == "three" && set->observer().inserted == 1);
+    set->get_or_insert(5) = "five";
+    assert(*set->find(5) == "five" && set->find_dense(5) == 1);
+    *set->find(3) += "!";
+    assert(*std::as_const(*set).find(3) == "three!" && std::as_const(*set).find(4) == nullptr);
+    delete set;
+}
+
+void test_assign()
+{
+    auto set = new sparse_set<std::vector<int>, 1024, observed_policy>;
+    set->insert_or_assign(3, std::vector<int>(100, 1));
+    const auto buffer = set->at(3).data();
+    const std::vector<int> path(50, 2);
+    set->insert_or_assign(3, path); //copy assignment reuses the existing buffer
+    assert(set->at(3).data() == buffer && set->at(3).size() == 50 && set->at(3)[0] == 2);
+    set->emplace_or_replace(3, size_t(10), 3);
+    assert(set->at(3).size() == 10 && set->at(3)[9] == 3);
+    set->emplace_or_replace(4, size_t(2), 4);
+    assert(set->at(4).size() == 2 && set->observer().inserted == 2 && set->observer().replaced == 2);
+    delete set;
+}
+
+void test_id_allocator()
+{
+    auto ids = new sparse_id_allocator<1024, 8>;
+    const auto first = ids->create();
+    const auto second = ids->create();
+    assert(first == 0 && second == 1 && ids->alive(first));
+    ids->destroy(first);
+    assert(!ids->alive(first) && ids->alive(second) && ids->size() == 1);
+    const auto recycled = ids->create();
+    assert(ids->index_of(recycled) == 0 && ids->generation_of(recycled) == 1);
+    assert(ids->alive(recycled) && !ids->alive(first));
+    ids->destroy(first); //stale, ignored
+    assert(ids->alive(recycled));
+
+    uint32_t batch[1022];
+    ids->create_many(1022, batch);
+    assert(ids->full() && ids->index_of(batch[1021]) == 1023);
+    bool thrown = false;
+    try { ids->create(); }
+    catch (const std::out_of_range&) { thrown = true; }
+    assert(thrown);
+    ids->destroy_many(batch, 1022);
+    assert(ids->size() == 2 && ids->alive(second) && ids->alive(recycled));
+    for (auto id : batch) assert(!ids->alive(id));
+    auto set = new sparse_set<int, 1024>;
+    for (auto id : ids->ids()) set->insert(ids->index_of(id), int(ids->generation_of(id)));
+    assert(set->at(0) == 1 && set->at(1) == 0);
+    ids->clear();
+    assert(ids->empty() && ids->generation_of(ids->create()) != 0);
+    delete set;
+    delete ids;
+}
+
+void test_registry()
+{
+    assert(sparse_set_type_id_of<Transform>() != sparse_set_type_id_of<Velocity>());
+    auto registry = new sparse_set_registry<1024>;
+    assert(registry->find_pool<Transform>() == nullptr);
+    for (uint32_t i = 0; i < 100; ++i) {
+        registry->pool<Transform>().insert(i);
+        if (i % 2) registry->pool<Velocity>().insert(i);
+        if (i % 3) registry->pool<Selected>().insert(i);
+    }
+    assert(registry->pools().size() == 3 && registry->find_pool<Velocity>() == &registry->pool<Velocity>());
+    assert((registry->contains<Transform, Velocity>(5) && !registry->contains<Transform, Velocity, Selected>(3)));
+    registry->erase(5);
+    registry->erase(5000);
+    for (auto& pool : registry->pools()) assert(!pool.contains(5) && !pool.contains(5000));
+    assert(registry->pools()[1].size() == 49 && registry->pools()[2].keys().size() == 65);
+    sparse_set<int, 16> local;
+    sparse_set_handle handle(local);
+    local.insert(3, 1);
+    assert(handle.contains(3) && handle.keys()[0] == 3 && handle.max_size() == 16);
+    handle.clear();
+    assert(local.empty() && handle.empty());
+    registry->clear();
+    for (auto& pool : registry->pools()) assert(pool.empty());
+    delete registry;
+}
+
+void test_runtime_set()
+{
+    auto strings = new runtime_sparse_set<1024>(sparse_set_element_info::of<std::string>());
+    const std::string hello = "hello, a string long enough to allocate";
+    for (uint32_t i = 0; i < 10; ++i) strings->insert(i * 2, &hello);
+    *(std::string*)strings->insert(1) = "one";
+    strings->erase(0);
+    strings->erase(4);
+    assert(strings->size() == 9 && *(std::string*)strings->at(18) == hello && *(std::string*)(*strings)[1] == "one");
+    uint32_t count = 0;
+    strings->for_each([&](uint32_t a_Index, void* a_Element) { assert(a_Index == 1 || *(std::string*)a_Element == hello); count++; });
+    assert(count == 9);
+    delete strings;
+
+    //a scripted component with no hooks, only known by its size and alignment
+    auto scripted = new runtime_sparse_set<64>({ 12, 32 });
+    assert(scripted->stride() == 32 && uintptr_t(scripted->data()) % 32 == 0);
+    const uint32_t values[3] = { 1, 2, 3 };
+    scripted->insert(5, values);
+    scripted->insert(6);
+    assert(((uint32_t*)scripted->at(5))[2] == 3 && ((uint32_t*)scripted->at(6))[2] == 0);
+    scripted->erase(5);
+    assert(scripted->keys()[0] == 6 && scripted->at(6) == scripted->data());
+
+    //plugin components are reached by registry-wide operations once attached
+    {
+        sparse_set_registry<64> registry;
+        registry.pool<Transform>().insert(6);
+        registry.attach(*scripted);
+        assert(registry.pools().size() == 2 && registry.pools()[1].contains(6));
+        registry.erase(6);
+        assert(scripted->empty() && registry.pool<Transform>().empty());
+    }
+    delete scripted;
+}
+
+#if __cplusplus >= 202002L
+struct Descriptor {
+    const char* name;
+    int cost;
+};
+
+constexpr auto descriptors = [] {
+    sparse_set<Descriptor, 64> set;
+    set.insert(3, Descriptor{ "three", 3 });
+    set.insert(42, Descriptor{ "forty two", 42 });
+    set.insert(7, Descriptor{ "seven", 7 });
+    set.erase(3);
+    return set;
+}();
+static_assert(descriptors.size() == 2 && !descriptors.contains(3));
+static_assert(descriptors.at(42).cost == 42 && descriptors[7].name[0] == 's');
+
+constexpr int constant_sum()
+{
+    sparse_set<int, 128> set;
+    for (uint32_t i = 0; i < 128; i += 2) set.insert(i, int(i));
+    for (uint32_t i = 0; i < 128; i += 4) set.erase(i);
+    int sum = 0;
+    set.for_each([&](uint32_t a_Index, int& a_Value) { sum += a_Value - int(a_Index) + 1; });
+    return sum + int(set.keys().size());
+}
+static_assert(constant_sum() == 64);
+
+constexpr bool constant_tags()
+{
+    sparse_set<void, 16> set;
+    set.insert(3);
+    set.insert(5);
+    set.erase(3);
+    return set.contains(5) && !set.contains(3) && set.size() == 1;
+}
+static_assert(constant_tags());
+#endif
+
+struct partition_policy : sparse_set_policy {
+    static constexpr bool partition = true;
+};
+
+struct paged_partition_policy : partition_policy {
+    static constexpr sparse_set_storage storage = sparse_set_storage::paged;
+    static constexpr uint32_t page_size = 4;
+};
+
+void test_partition()
+{
+    auto set = new sparse_set<uint32_t, 1024, partition_policy>;
+    for (uint32_t i = 0; i < 8; ++i) set->insert(i, i * 10);
+    set->disable(2);
+    set->disable(5);
+    set->disable(5); //already disabled, ignored
+    assert(set->size() == 8 && set->enabled_size() == 6 && !set->enabled(2) && set->enabled(3));
+    uint32_t visited = 0;
+    set->for_each([&](uint32_t a_Index, uint32_t a_Value) {
+        assert(a_Index != 2 && a_Index != 5 && a_Value == a_Index * 10);
+        visited++;
+    });
+    assert(visited == 6 && set->enabled_keys().size() == 6 && set->keys().size() == 8);
+    set->insert(9, 90u); //enabled, the first disabled element moves to the end
+    assert(set->enabled_size() == 7 && set->at(2) == 20 && set->at(5) == 50);
+    set->erase(0); //enabled
+    set->erase(5); //disabled
+    assert(set->size() == 7 && set->enabled_size() == 6 && set->at(2) == 20 && !set->contains(5));
+    set->enable(2);
+    assert(set->enabled(2) && set->enabled_size() == 7 && set->at(2) == 20);
+    for (auto index : set->enabled_keys()) assert(set->at(index) == index * 10);
+    const auto frozen = sparse_set_freeze(*set); //disabled elements are kept
+    assert(frozen.size() == 7 && frozen.at(6) == 60);
+    set->disable(6);
+    uint32_t disabled = 0;
+    set->for_each_disabled([&](uint32_t a_Index, uint32_t) { assert(a_Index == 6); disabled++; });
+    assert(disabled == 1 && sparse_set_freeze(*set).size() == 7);
+    set->clear();
+    assert(set->enabled_size() == 0 && set->empty());
+    delete set;
+
+    sparse_set<std::string, 16, partition_policy> strings; //short strings point into themselves
+    for (uint32_t i = 0; i < 4; ++i) strings.insert(i, std::string(1, char('a' + i)));
+    strings.disable(0);
+    strings.insert(4, "e");
+    strings.at(0) = "z";
+    strings.enable(0);
+    strings.erase(2);
+    assert(strings.at(0) == "z" && strings.at(1) == "b" && strings.at(3) == "d" && strings.at(4) == "e");
+
+    sparse_set<Fragile, 16, partition_policy> fragile;
+    for (uint32_t i = 1; i < 4; ++i) fragile.insert(i, "ok");
+    fragile.disable(1);
+    test_throwing_insert(fragile);
+    uint32_t enabledCount = 0;
+    fragile.for_each([&](uint32_t a_Index, Fragile&) { assert(a_Index != 1); enabledCount++; });
+    assert(enabledCount == 2 && fragile.enabled_size() == 2 && fragile.size() == 3 && !fragile.enabled(1));
+
+    sparse_set<int, 64, paged_partition_policy> paged;
+    for (uint32_t i = 0; i < 4; ++i) paged.insert(i, int(i));
+    paged.disable(1);
+    paged.insert(4, 4); //moves the disabled element into the second page, not allocated yet
+    assert(paged.at(1) == 1 && paged.at(4) == 4 && !paged.enabled(1) && paged.enabled_size() == 4);
+}
+
+void test_erase_while_iterating()
+{
+    auto set = new sparse_set<int, 1024>;
+    for (uint32_t i = 0; i < 100; ++i) set->insert(i, int(i));
+    uint32_t visited = 0;
+    set->for_each_erasable([&](uint32_t a_Index, int& a_Value) {
+        visited++;
+        if (a_Value % 3 == 0) set->erase(a_Index);
+    });
+    assert(visited == 100 && set->size() == 66 && !set->contains(99) && set->contains(98));
+    {
+        sparse_set_deferred_erase pending(*set);
+        set->for_each([&](uint32_t a_Index, int& a_Value) { if (a_Value % 2 == 0) pending.erase(a_Index); });
+        assert(pending.size() == 33 && set->size() == 66);
+    }
+    assert(set->size() == 33);
+    set->for_each([&](uint32_t, int& a_Value) { assert(a_Value % 2 != 0 && a_Value % 3 != 0); });
+    {
+        sparse_set_deferred_erase pending(*set);
+        bool thrown = false;
+        try { pending.erase(5000); } //rejected when queued, flushing can't throw
+        catch (const std::out_of_range&) { thrown = true; }
+        assert(thrown && pending.size() == 0);
+    }
+    delete set;
+}
+
+struct ordered_erase_policy : sparse_set_policy {
+    static constexpr sparse_set_erase erase = sparse_set_erase::ordered;
+};
+
+void test_ordered_erase()
+{
+    auto set = new sparse_set<uint32_t, 1024, ordered_erase_policy>;
+    const uint32_t inserted[] = { 40, 7, 300, 12, 99, 5, 18, 600 };
+    for (auto index : inserted) set->insert(index, index * 2);
+    set->erase(7);
+    set->erase(99);
+    const uint32_t batch[] = { 600, 40, 40, 1000 }; //duplicates and absent indice are ignored
+    set->erase_many(batch, 4);
+    const uint32_t expected[] = { 300, 12, 5, 18 };
+    assert(set->size() == 4 && std::equal(set->keys().begin(), set->keys().end(), expected));
+    set->for_each([](uint32_t a_Index, uint32_t a_Value) { assert(a_Value == a_Index * 2); });
+    set->insert(7, 14u); //inserting appends
+    assert(set->keys()[4] == 7 && set->at(12) == 24 && set->at(7) == 14);
+    set->for_each_erasable([&](uint32_t a_Index, uint32_t) { if (a_Index < 15) set->erase(a_Index); });
+    const uint32_t kept[] = { 300, 18 };
+    assert(set->size() == 2 && std::equal(set->keys().begin(), set->keys().end(), kept));
+
+    auto ranked = new sparse_set<std::string, 4096, ranked_policy>;
+    for (uint32_t i = 0; i < 200; ++i) ranked->insert(i * 7 % 200, std::string(32, char('a' + i * 7 % 200 % 26)));
+    uint32_t odd[101];
+    for (uint32_t i = 0; i < 100; ++i) odd[i] = i * 2 + 1;
+    odd[100] = 3;
+    ranked->erase_many(odd, 101);
+    assert(ranked->size() == 100);
+    for (uint32_t i = 0; i < 100; ++i) assert(ranked->keys()[i] == i * 2 && ranked->at(i * 2) == std::string(32, char('a' + i * 2 % 26)));
+    delete ranked;
+    delete set;
+
+    auto strings = new sparse_set<std::string, 1024, ordered_erase_policy>;
+    for (uint32_t i = 0; i < 4; ++i) strings->insert(i, std::string(32, char('a' + i)));
+    const uint32_t outOfBound[] = { 2, 1000, 4096 };
+    bool thrown = false;
+    try { strings->erase_many(outOfBound, 3); }
+    catch (const std::out_of_range&) { thrown = true; }
+    assert(thrown && strings->size() == 4 && strings->at(2) == std::string(32, 'c')); //nothing was erased
+    delete strings;
+
+    //short strings point into themselves, shifting must move them properly
+    sparse_set<std::string, 16, ordered_erase_policy> shortStrings;
+    for (uint32_t i = 0; i < 6; ++i) shortStrings.insert(i, std::string(1, char('a' + i)));
+    shortStrings.erase(1);
+    shortStrings.at(2) = "z";
+    const uint32_t shortBatch[] = { 0, 3 };
+    shortStrings.erase_many(shortBatch, 2);
+    assert(shortStrings.size() == 3 && shortStrings.at(2) == "z" && shortStrings.at(4) == "e" && shortStrings.at(5) == "f");
+}
+
 int main()
 {
     auto sparseSet = new sparse_set<Transform, 65536>;
@@ -23,4 +882,29 @@ int main()
         else assert(sparseSet->contains(i));
     }
     delete sparseSet;
-}
\ No newline at end of file
+    test_delta();
+    test_observer();
+    test_contains_many();
+    test_get_many();
+    test_algebra();
+    test_indirect_storage();
+    test_tombstones();
+    test_paged_storage();
+    test_tags();
+    test_table();
+    test_soa_storage();
+    test_aosoa_storage();
+    test_rank_lookup();
+    test_paged_rank_lookup();
+    test_ordered_iteration();
+    test_freeze();
+    test_checks();
+    test_find();
+    test_assign();
+    test_id_allocator();
+    test_registry();
+    test_runtime_set();
+    test_partition();
+    test_erase_while_iterating();
+    test_ordered_erase();
+}